@@ -33,14 +33,21 @@ analyze_base_worker<GEOMETRY>::analyze_precise (
             w_red, w_green, area, simulated_screen) default(none) \
 	    if (area.height > size || this->m_area.height > size2)
   {
+    /* Screen coordinates of the current row.  */
+    std::vector<point_t> scr_row (area.width);
 #pragma omp for
     for (int y = area.y; y < area.y + area.height; y++)
       {
+        if (!progress || !progress->cancel_requested ())
+          {
+            for (int x = 0; x < area.width; x++)
+              scr_row[x] = { area.x + x + (coord_t) 0.5, y + (coord_t) 0.5 };
+            scr_to_img->to_scr (scr_row.data (), scr_row.data (), area.width);
+          }
         if (!progress || !progress->cancel_requested ())
           for (int x = area.x; x < area.x + area.width; x++)
             {
-              point_t scr = scr_to_img->to_scr (
-                  { x + (coord_t) 0.5, y + (coord_t) 0.5 });
+              point_t scr = scr_row[x - area.x];
               scr += { (coord_t)m_area.xshift (), (coord_t)m_area.yshift () };
               /* Dufay analyzer shifts red strip and some pixels gets accounted
                  to neighbouring screen tile; add extra bffer of 1 screen tile
@@ -261,14 +268,21 @@ analyze_base_worker<GEOMETRY>::analyze_precise_rgb (
             w_red, w_green, area, simulated_screen) default(none) \
 	    if (area.height > size || this->m_area.height > size2)
   {
+    /* Screen coordinates of the current row.  */
+    std::vector<point_t> scr_row (area.width);
 #pragma omp for
     for (int y = area.y; y < area.y + area.height; y++)
       {
+        if (!progress || !progress->cancel_requested ())
+          {
+            for (int x = 0; x < area.width; x++)
+              scr_row[x] = { area.x + x + (coord_t) 0.5, y + (coord_t) 0.5 };
+            scr_to_img->to_scr (scr_row.data (), scr_row.data (), area.width);
+          }
         if (!progress || !progress->cancel_requested ())
           for (int x = area.x; x < area.x + area.width; x++)
             {
-              point_t scr = scr_to_img->to_scr (
-                  { x + (coord_t) 0.5, y + (coord_t) 0.5 });
+              point_t scr = scr_row[x - area.x];
               scr += { (coord_t)m_area.xshift (), (coord_t)m_area.yshift () };
               if (!GEOMETRY::check_range
                   && (scr.x < (coord_t) 0 || scr.x > (coord_t)m_area.width - 1
@@ -522,6 +536,8 @@ analyze_base_worker<GEOMETRY>::analyze_color (
             weights) default(none) if (area.height > size                     \
                                            || this->m_area.height > size2)
   {
+    /* Screen coordinates of the current row.  */
+    std::vector<point_t> scr_row (area.width);
 #pragma omp for
     for (int y = area.y; y < area.y + area.height; y++)
       {
@@ -529,11 +545,16 @@ analyze_base_worker<GEOMETRY>::analyze_color (
                 blue_minx = -2, blue_miny = -2;
         int64_t red_maxx = 2, red_maxy = 2, green_maxx = 2, green_maxy = 2,
                 blue_maxx = 2, blue_maxy = 2;
+        if (!progress || !progress->cancel_requested ())
+          {
+            for (int x = 0; x < area.width; x++)
+              scr_row[x] = { area.x + x + (coord_t) 0.5, y + (coord_t) 0.5 };
+            scr_to_img->to_scr (scr_row.data (), scr_row.data (), area.width);
+          }
         if (!progress || !progress->cancel_requested ())
           for (int x = area.x; x < area.x + area.width; x++)
             {
-              point_t scr = scr_to_img->to_scr (
-                  { x + (coord_t) 0.5, y + (coord_t) 0.5 });
+              point_t scr = scr_row[x - area.x];
               scr += { (coord_t)m_area.xshift (), (coord_t)m_area.yshift () };
               if (!GEOMETRY::check_range
                   && (scr.x < (coord_t) 0 || scr.x > (coord_t)m_area.width - 1
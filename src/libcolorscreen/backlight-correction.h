@@ -1,6 +1,8 @@
 #ifndef BACKLIGHT_CORRECTION_H
 #define BACKLIGHT_CORRECTION_H
 #include <vector>
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <cassert>
 #include "include/color.h"
@@ -43,7 +45,7 @@ public:
     int xx, yy;
     coord_t rx = my_modf (x * m_img_width_rec, &xx);
     coord_t ry = my_modf (y * m_img_height_rec, &yy);
-    if (!safe && (xx < 0 || xx >= m_width || y < 0 || yy >= m_width))
+    if (!safe && (xx < 0 || xx >= m_width || y < 0 || yy >= m_height))
       return val;
     struct entry &e00 = m_weights[yy * m_width + xx];
     struct entry &e10 = m_weights[yy * m_width + xx + (xx == m_width - 1 ? 0 : 1)];
@@ -68,6 +70,123 @@ public:
     //printf ("%f %f %f %i\n",val,m_black,mult, channel);
     return (val - m_black) * mult + m_black;
   }
+
+  /* Correction weights of a single image row.  The vertical interpolation
+     is done once by prepare_row so applying the correction to a pixel needs
+     only horizontal interpolation.  */
+  struct row
+  {
+    /* Image row the weights were prepared for; -1 if not prepared.  */
+    int y = -1;
+    /* True if row is outside of the correction grid and no correction
+       should be applied.  */
+    bool out_of_range = false;
+    /* Weights interpolated vertically; one entry per grid column.  */
+    std::vector<entry> weights;
+  };
+
+  /* Prepare R for applying correction to image row Y.  If SAFE is true,
+     Y is known to be inside of the image.  */
+  void
+  prepare_row (row &r, int y, bool safe = false)
+  {
+    int yy;
+    coord_t ry = my_modf (y * m_img_height_rec, &yy);
+    r.y = y;
+    r.out_of_range = !safe && (y < 0 || yy >= m_height);
+    if (r.out_of_range)
+      return;
+    r.weights.resize (m_width);
+    const entry *e0 = m_weights + yy * m_width;
+    const entry *e1 = e0 + (yy == m_height - 1 ? 0 : m_width);
+    for (int xx = 0; xx < m_width; xx++)
+      for (int c = 0; c < 4; c++)
+	{
+	  r.weights[xx].mult[c] = e0[xx].mult[c] * (1 - ry) + e1[xx].mult[c] * ry;
+	  r.weights[xx].sub[c] = e0[xx].sub[c] * (1 - ry) + e1[xx].sub[c] * ry;
+	}
+  }
+
+  /* Same as apply above but use weights R prepared for the row of pixel.  */
+  inline luminosity_t
+  apply (const row &r, float val, int x, enum backlight_correction_parameters::channel channel, bool safe = false)
+  {
+    if (r.out_of_range)
+      return val;
+    int xx;
+    coord_t rx = my_modf (x * m_img_width_rec, &xx);
+    if (!safe && (xx < 0 || xx >= m_width))
+      return val;
+    const entry &e0 = r.weights[xx];
+    const entry &e1 = r.weights[xx + (xx == m_width - 1 ? 0 : 1)];
+    luminosity_t mult = e0.mult[channel] + (e1.mult[channel] - e0.mult[channel]) * rx;
+    if (black_correction)
+      val -= e0.sub[channel] + (e1.sub[channel] - e0.sub[channel]) * rx;
+    return (val - m_black) * mult + m_black;
+  }
+
+  /* Apply correction in place to N values VALS of pixels X0...X0+N-1 of row
+     prepared in R.  Weights are stepped incrementally within every grid cell,
+     so the correction costs about one multiply-add per sample.  */
+  void
+  apply_row (const row &r, luminosity_t *vals, int x0, int n, enum backlight_correction_parameters::channel channel)
+  {
+    if (r.out_of_range)
+      return;
+    int end = x0 + n;
+    for (int x = x0; x < end;)
+      {
+	int xx;
+	coord_t rx = my_modf (x * m_img_width_rec, &xx);
+	if (xx < 0 || xx >= m_width)
+	  {
+	    x++;
+	    continue;
+	  }
+	/* First pixel of the next grid cell.  */
+	int cell_end = std::min (end, std::max (x + 1, (int)ceil ((xx + 1) / m_img_width_rec)));
+	const entry &e0 = r.weights[xx];
+	const entry &e1 = r.weights[xx + (xx == m_width - 1 ? 0 : 1)];
+	luminosity_t dmult = e1.mult[channel] - e0.mult[channel];
+	luminosity_t mult = e0.mult[channel] + dmult * rx;
+	dmult *= m_img_width_rec;
+	luminosity_t dsub = 0, sub = 0;
+	if (black_correction)
+	  {
+	    dsub = e1.sub[channel] - e0.sub[channel];
+	    sub = e0.sub[channel] + dsub * rx;
+	    dsub *= m_img_width_rec;
+	  }
+	for (; x < cell_end; x++)
+	  {
+	    vals[x - x0] = (vals[x - x0] - sub - m_black) * mult + m_black;
+	    mult += dmult;
+	    sub += dsub;
+	  }
+      }
+  }
+
+  /* Return the first pixel of the grid cell containing pixel X.  This is
+     the last pixel not after X at which apply_row started at pixel 0 begins
+     a new cell, so applying the correction from it gives the same values as
+     applying it from the beginning of the row.  */
+  int
+  cell_start (int x) const
+  {
+    int start = 0;
+    for (int p = 0; p <= x;)
+      {
+	int xx;
+	my_modf (p * m_img_width_rec, &xx);
+	/* Outside of the grid every pixel is processed separately.  */
+	if (xx < 0 || xx >= m_width)
+	  return x;
+	start = p;
+	p = std::max (p + 1, (int)ceil ((xx + 1) / m_img_width_rec));
+      }
+    return start;
+  }
+
   bool initialized_p ()
   {
     return m_weights != NULL;
@@ -0,0 +1,282 @@
+#ifndef BFGS_H
+#define BFGS_H
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "include/progress-info.h"
+#include "nmsimplex.h"
+
+namespace colorscreen
+{
+
+/* Evaluate C.OBJFUNC at N points.  A client that defines
+
+       void objfuncs (int n, T *const *points, T *values)
+
+   may evaluate the points in parallel (typically using independent copies
+   of its state); otherwise points are evaluated one by one.  */
+template <typename T, typename C>
+static auto
+evaluate_objfuncs (C &c, int n, T *const *points, T *values, int)
+    -> decltype (c.objfuncs (n, points, values), void ())
+{
+  c.objfuncs (n, points, values);
+}
+
+template <typename T, typename C>
+static void
+evaluate_objfuncs (C &c, int n, T *const *points, T *values, long)
+{
+  for (int i = 0; i < n; i++)
+    values[i] = c.objfunc (points[i]);
+}
+
+/* Minimize C.OBJFUNC using quasi-Newton BFGS method with gradients
+   estimated by finite differences.  The interface is the same as
+   of SIMPLEX: C supplies the initial vector C.START, NUM_VALUES, SCALE,
+   EPSILON, CONSTRAIN and VERBOSE.  SCALE is the expected size of the
+   first step; finite difference steps are derived from it.  All
+   evaluations needed for one gradient are passed to C.OBJFUNCS at once if
+   the client provides it.  TASK, PROGRESS and PROGRESS_REPORT have same
+   meaning as for SIMPLEX.  MAX_ITERATIONS bounds the number of gradient
+   evaluations.  Return the objective value at the final point.  */
+template <typename T, typename C>
+double
+bfgs (C &c, const char *task = NULL, progress_info *progress = NULL,
+      bool progress_report = true, int max_iterations = 1000)
+{
+  const int n = c.num_values ();
+  const T EPSILON = c.epsilon ();
+  const T scale = c.scale ();
+  /* Finite difference step.  */
+  const T h = scale / 1000;
+  /* Armijo condition constant and maximal number of step halvings.  */
+  const T armijo = (T)1e-4;
+  const int max_halvings = 20;
+
+  if (n == 0)
+    {
+      if (progress && progress_report)
+        progress->set_task (task, 1);
+      T value = c.objfunc (nullptr);
+      report_simplex_profile (c, 1, 0, 0);
+      if (progress && progress_report)
+        progress->inc_progress ();
+      return value;
+    }
+  if (progress && progress_report)
+    progress->set_task (task, max_iterations);
+
+  std::vector<T> x (n), xn (n), g (n), gn (n), d (n), s (n), y (n), hy (n);
+  /* Inverse Hessian approximation.  */
+  std::vector<T> H (n * n);
+  /* Points and values used by finite differences.  */
+  std::vector<T> fd_points (2 * n * n);
+  std::vector<T *> fd_ptrs (2 * n);
+  std::vector<T> fd_values (2 * n);
+  /* Forward differences are used until they stop giving descent
+     directions; then we switch to more precise central differences.  */
+  bool central = false;
+  int k = 0;
+  int itr = 0;
+
+  for (int i = 0; i < n; i++)
+    x[i] = c.start[i];
+  c.constrain (x.data ());
+  T f = c.objfunc (x.data ());
+  k++;
+
+  /* Set PT to P moved by STEP in coordinate I.  */
+  auto fd_point = [&] (std::vector<T> &p, int i, T step, T *pt)
+    {
+      for (int j = 0; j < n; j++)
+	pt[j] = p[j];
+      pt[i] += step;
+      c.constrain (pt);
+    };
+  /* Estimate gradient G at point P with value FP.  */
+  auto gradient = [&] (std::vector<T> &p, T fp, std::vector<T> &grad)
+    {
+      int m = central ? 2 * n : n;
+      for (int i = 0; i < n; i++)
+	{
+	  fd_ptrs[i] = &fd_points[i * n];
+	  fd_point (p, i, h, fd_ptrs[i]);
+	  /* Constraint may clamp the coordinate; step back instead.  */
+	  if (!central && std::fabs (fd_ptrs[i][i] - p[i]) < h / 2)
+	    fd_point (p, i, -h, fd_ptrs[i]);
+	  if (central)
+	    {
+	      fd_ptrs[n + i] = &fd_points[(n + i) * n];
+	      fd_point (p, i, -h, fd_ptrs[n + i]);
+	    }
+	}
+      evaluate_objfuncs<T, C> (c, m, fd_ptrs.data (), fd_values.data (), 0);
+      k += m;
+      for (int i = 0; i < n; i++)
+	{
+	  T v1 = fd_values[i], v2 = central ? fd_values[n + i] : fp;
+	  T delta = fd_ptrs[i][i] - (central ? fd_ptrs[n + i][i] : p[i]);
+	  grad[i] = delta != 0 && std::isfinite (v1) && std::isfinite (v2)
+		    ? (v1 - v2) / delta : 0;
+	}
+    };
+  /* Reset H to identity scaled so the steepest descent step has length
+     SCALE.  */
+  auto reset_hessian = [&] ()
+    {
+      T len = 0;
+      for (int i = 0; i < n; i++)
+	len += g[i] * g[i];
+      len = std::sqrt (len);
+      for (int i = 0; i < n * n; i++)
+	H[i] = 0;
+      for (int i = 0; i < n; i++)
+	H[i * n + i] = len > 0 ? scale / len : scale;
+    };
+
+  gradient (x, f, g);
+  reset_hessian ();
+  bool fresh_hessian = true;
+  int stalled = 0;
+
+  for (itr = 1; itr <= max_iterations; itr++)
+    {
+      /* Search direction D = -H G.  */
+      T slope = 0;
+      for (int i = 0; i < n; i++)
+	{
+	  T sum = 0;
+	  for (int j = 0; j < n; j++)
+	    sum -= H[i * n + j] * g[j];
+	  d[i] = sum;
+	  slope += sum * g[i];
+	}
+      if (!(slope < 0))
+	{
+	  if (fresh_hessian)
+	    break;
+	  reset_hessian ();
+	  fresh_hessian = true;
+	  itr--;
+	  continue;
+	}
+
+      /* Backtracking line search.  */
+      T alpha = 1;
+      T fn = 0;
+      bool found = false;
+      for (int l = 0; l < max_halvings; l++, alpha /= 2)
+	{
+	  for (int i = 0; i < n; i++)
+	    xn[i] = x[i] + alpha * d[i];
+	  c.constrain (xn.data ());
+	  fn = c.objfunc (xn.data ());
+	  k++;
+	  if (std::isfinite (fn) && fn <= f + armijo * alpha * slope)
+	    {
+	      found = true;
+	      break;
+	    }
+	}
+      if (!found)
+	{
+	  /* Inverse Hessian may be poor; retry with steepest descent.
+	     If even that fails, the gradient is not precise enough.  */
+	  if (fresh_hessian)
+	    {
+	      if (central)
+		break;
+	      central = true;
+	      gradient (x, f, g);
+	    }
+	  reset_hessian ();
+	  fresh_hessian = true;
+	  continue;
+	}
+
+      gradient (xn, fn, gn);
+      T sy = 0, yy = 0;
+      for (int i = 0; i < n; i++)
+	{
+	  s[i] = xn[i] - x[i];
+	  y[i] = gn[i] - g[i];
+	  sy += s[i] * y[i];
+	  yy += y[i] * y[i];
+	}
+      T improvement = f - fn;
+      x = xn;
+      g = gn;
+      f = fn;
+
+      /* BFGS update of the inverse Hessian
+	 H = (I - rho s y^T) H (I - rho y s^T) + rho s s^T.
+	 Skip it if curvature condition does not hold.  */
+      if (sy > 0 && yy > 0)
+	{
+	  if (fresh_hessian)
+	    for (int i = 0; i < n; i++)
+	      for (int j = 0; j < n; j++)
+		H[i * n + j] = i == j ? sy / yy : 0;
+	  T rho = 1 / sy;
+	  T yhy = 0;
+	  for (int i = 0; i < n; i++)
+	    {
+	      T sum = 0;
+	      for (int j = 0; j < n; j++)
+		sum += H[i * n + j] * y[j];
+	      hy[i] = sum;
+	      yhy += y[i] * sum;
+	    }
+	  for (int i = 0; i < n; i++)
+	    for (int j = 0; j < n; j++)
+	      H[i * n + j] += rho * ((1 + rho * yhy) * s[i] * s[j]
+				     - hy[i] * s[j] - s[i] * hy[j]);
+	  fresh_hessian = false;
+	}
+
+      if (c.verbose ())
+	{
+	  printf ("Iteration %d value %f\n", itr, (double)f);
+	  for (int i = 0; i < n; i++)
+	    printf ("%i:%f\n", i, (double)x[i]);
+	}
+      if (progress && progress_report)
+	progress->inc_progress ();
+      if (progress && progress->cancel_requested ())
+	break;
+      /* EPSILON is the same tolerance simplex uses for spread of values.
+	 Small improvements with forward differences are often caused by
+	 imprecise gradient, so try central differences before giving up.  */
+      if (improvement < EPSILON)
+	{
+	  if (++stalled >= 2)
+	    {
+	      if (central)
+		break;
+	      central = true;
+	      stalled = 0;
+	      gradient (x, f, g);
+	      reset_hessian ();
+	      fresh_hessian = true;
+	    }
+	}
+      else
+	stalled = 0;
+    }
+
+  for (int i = 0; i < n; i++)
+    c.start[i] = x[i];
+  /* Leave the client in state corresponding to the final point.  */
+  T min = c.objfunc (x.data ());
+  k++;
+  report_simplex_profile (c, k, std::min (itr, max_iterations), 0);
+  if (c.verbose ())
+    {
+      printf ("%d Function Evaluations\n", k);
+      printf ("%d Iterations through program\n", itr);
+    }
+  return min;
+}
+}
+#endif
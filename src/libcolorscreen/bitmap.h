@@ -133,5 +133,47 @@ public:
   }
   size_t width, height;
 };
+
+/* 2d bitmap covering only the WIDTH x HEIGHT window with top left corner
+   XOFFSET, YOFFSET of a larger image.  Coordinates are those of the larger
+   image.  Bits outside of the window read as set and can not be changed, so
+   searches using the bitmap never leave the window.  */
+class window_bitmap_2d
+{
+public:
+  window_bitmap_2d (int xoffset1, int yoffset1, int width1, int height1)
+      : xoffset (xoffset1), yoffset (yoffset1), map (width1, height1)
+  {
+  }
+  pure_attr bool
+  in_range_p (int64_t x, int64_t y) const
+  {
+    return x >= xoffset && y >= yoffset && (size_t)(x - xoffset) < map.width
+           && (size_t)(y - yoffset) < map.height;
+  }
+  pure_attr bool
+  test_bit (int64_t x, int64_t y) const
+  {
+    if (!in_range_p (x, y))
+      return true;
+    return map.test_bit (x - xoffset, y - yoffset);
+  }
+  bool
+  set_bit (int64_t x, int64_t y)
+  {
+    if (!in_range_p (x, y))
+      return true;
+    return map.set_bit (x - xoffset, y - yoffset);
+  }
+  bool
+  clear_bit (int64_t x, int64_t y)
+  {
+    if (!in_range_p (x, y))
+      return true;
+    return map.clear_bit (x - xoffset, y - yoffset);
+  }
+  int xoffset, yoffset;
+  bitmap_2d map;
+};
 }
 #endif
@@ -0,0 +1,158 @@
+/* Piecewise bilinear approximation of coordinate mappings.
+   Copyright (C) 2014-2026 Jan Hubicka
+   This file is part of Color-Screen.  */
+
+#ifndef COORDINATE_GRID_H
+#define COORDINATE_GRID_H
+#include <algorithm>
+#include <vector>
+#include "include/base.h"
+
+namespace colorscreen
+{
+
+/* Approximation of a smooth mapping (such as scr_to_img::to_scr) by its
+   values on a regular grid.  Inside each grid cell the mapping is
+   interpolated bilinearly, which replaces lens correction, homography
+   divides and mesh lookups by a few multiply-adds per pixel.  */
+class coordinate_grid
+{
+public:
+  coordinate_grid ()
+  : m_origin ({0, 0}), m_step (0), m_inv_step (0), m_xsteps (0),
+    m_ysteps (0), m_error (0)
+  { }
+
+  /* Initialize approximation of mapping F on area AREA.  Start with grid
+     cells of size MAX_STEP and halve them until the difference between F
+     and the approximation, sampled on a 4x4 lattice within every cell, is
+     at most half of MAX_ERROR.  The difference of a smooth mapping changes
+     little between the samples, so it stays within MAX_ERROR everywhere.
+     Return false if this needs cells smaller than MIN_STEP; the grid is
+     then unusable.  */
+  template <typename F>
+  bool
+  init (F &&f, image_area area, coord_t max_error, coord_t max_step = 64,
+        coord_t min_step = 4)
+  {
+    clear ();
+    if (!(max_error > 0) || area.width <= 0 || area.height <= 0)
+      return false;
+    for (coord_t step = max_step; step >= min_step; step /= 2)
+      {
+        m_origin = { area.x, area.y };
+        m_step = step;
+        m_inv_step = 1 / step;
+        m_xsteps = std::max ((int)my_ceil (area.width / step), 1);
+        m_ysteps = std::max ((int)my_ceil (area.height / step), 1);
+        m_points.resize ((m_xsteps + 1) * (size_t)(m_ysteps + 1));
+        int w = m_xsteps + 1;
+        int ysteps = m_ysteps;
+#pragma omp parallel for default(none) schedule(dynamic) shared(f, w, ysteps, step, area)
+        for (int y = 0; y <= ysteps; y++)
+          for (int x = 0; x < w; x++)
+            m_points[y * (size_t)w + x]
+                = f (point_t{ area.x + x * step, area.y + y * step });
+        m_error = measure_error (f);
+        if (m_error <= max_error / 2)
+          return true;
+      }
+    clear ();
+    return false;
+  }
+
+  /* Return true if the approximation was successfully initialized.  */
+  pure_attr bool
+  initialized_p () const
+  {
+    return !m_points.empty ();
+  }
+
+  /* Return true if P is within the area covered by the grid.  */
+  pure_attr bool
+  in_range_p (point_t p) const
+  {
+    return initialized_p () && p.x >= m_origin.x && p.y >= m_origin.y
+           && p.x <= m_origin.x + m_xsteps * m_step
+           && p.y <= m_origin.y + m_ysteps * m_step;
+  }
+
+  /* Return approximate value of the mapping at P.  Points outside of the
+     grid are extrapolated from the nearest cell.  */
+  pure_attr inline point_t
+  apply (point_t p) const
+  {
+    coord_t fx = (p.x - m_origin.x) * m_inv_step;
+    coord_t fy = (p.y - m_origin.y) * m_inv_step;
+    int ix = std::clamp ((int)my_floor (fx), 0, m_xsteps - 1);
+    int iy = std::clamp ((int)my_floor (fy), 0, m_ysteps - 1);
+    fx -= ix;
+    fy -= iy;
+    const point_t *p0 = &m_points[iy * (size_t)(m_xsteps + 1) + ix];
+    const point_t *p1 = p0 + m_xsteps + 1;
+    point_t top = p0[0] + (p0[1] - p0[0]) * fx;
+    point_t bottom = p1[0] + (p1[1] - p1[0]) * fx;
+    return top + (bottom - top) * fy;
+  }
+
+  /* Return size of grid cells.  */
+  pure_attr coord_t
+  step () const
+  {
+    return m_step;
+  }
+
+  /* Return maximal error found while building the grid.  */
+  pure_attr coord_t
+  error () const
+  {
+    return m_error;
+  }
+
+  void
+  clear ()
+  {
+    m_points.clear ();
+    m_step = m_inv_step = 0;
+    m_xsteps = m_ysteps = 0;
+    m_error = 0;
+  }
+
+private:
+  /* Top left corner of the grid.  */
+  point_t m_origin;
+  /* Size of a cell and its inverse.  */
+  coord_t m_step, m_inv_step;
+  /* Number of cells in each direction.  */
+  int m_xsteps, m_ysteps;
+  /* Maximal error found by measure_error.  */
+  coord_t m_error;
+  /* Values of the mapping in grid points.  */
+  std::vector<point_t> m_points;
+
+  /* Return maximal distance of F and the approximation in points of cells
+     with coordinates being multiples of a quarter of the cell size.  The
+     bilinear interpolation is exact in grid points, so they are skipped.  */
+  template <typename F>
+  coord_t
+  measure_error (F &f) const
+  {
+    coord_t err = 0;
+    int xsteps = m_xsteps, ysteps = m_ysteps;
+    coord_t step = m_step;
+    point_t origin = m_origin;
+    const int sub = 4;
+#pragma omp parallel for default(none) schedule(dynamic) shared(f, xsteps, ysteps, step, origin) reduction(max:err)
+    for (int y = 0; y <= ysteps * sub; y++)
+      for (int x = 0; x <= xsteps * sub; x++)
+        if (x % sub || y % sub)
+          {
+            point_t p = { origin.x + x * step / sub,
+                          origin.y + y * step / sub };
+            err = std::max (err, f (p).dist_from (apply (p)));
+          }
+    return err;
+  }
+};
+}
+#endif
@@ -39,7 +39,9 @@ trans_4d_matrix get_matrix_5points (bool invert, scanner_type type,
    If FLAGS contains solve_screen_weights or solve_image_weights
    then adjust weight according to distance from WCENTER.
    If CHISQ_RET is non-NULL initialize it to square of errors.
-   If FINAL_RUN is true then this is the final call to RANSAC.  */
+   If FINAL_RUN is true then this is the final call to RANSAC.
+   Number of iterations is adapted to the inlier ratio found so far and
+   the result does not depend on number of threads used.  */
 trans_4d_matrix get_matrix_ransac (const std::vector <solver_parameters::solver_point_t> &points,
                                    int flags, scanner_type type,
                                    scr_to_img *map, point_t wcenter,
@@ -1,7 +1,10 @@
 #ifndef ANALYZE_SCANNER_BLUR_H
 #define ANALYZE_SCANNER_BLUR_H
 #include <cassert>
+#include <chrono>
+#include <mutex>
 #include <string>
+#include <vector>
 #include "colorscreen.h"
 #include "finetune.h"
 #include "histogram.h"
@@ -37,6 +40,9 @@ public:
         verbose (false),
         report_profile (false), interpolate_focus (false),
         focus_mtf_threshold ((coord_t)0.05), focus_interpolation_nodes (49),
+        checkpoint_file (NULL), checkpoint_interval (60),
+        shard_row_begin (0), shard_row_end (-1), shard_column_begin (0),
+        shard_column_end (-1),
         focus_interpolation_max (0), focus_screen_frequency (0)
   {
   }
@@ -92,6 +98,28 @@ public:
   /* Number of quadratically spaced exact cache nodes, including endpoints.
      The current linked-list LRU cache has 64 entries.  */
   int focus_interpolation_nodes;
+  /* If nonnull, completed prepass and dense-grid fits are periodically
+     written to this file and STEP1 resumes from it when it exists, so only
+     unfinished samples are computed again.  The caller must resume with the
+     same scan, geometry, rendering parameters and settings; checkpoints
+     of analyses with different ones are rejected.  */
+  const char *checkpoint_file;
+  /* Minimal number of seconds between two checkpoint writes.  Zero writes
+     the checkpoint after every completed fit.  */
+  coord_t checkpoint_interval;
+  /* Partial results (checkpoints of sharded analyses) loaded by STEP1.  All
+     must come from the same analysis; fits missing in all of them are
+     computed as usual.  */
+  std::vector<std::string> merge_files;
+  /* Restrict the dense pass to correction-table rows
+     [SHARD_ROW_BEGIN, SHARD_ROW_END) and columns
+     [SHARD_COLUMN_BEGIN, SHARD_COLUMN_END); negative end means the last
+     row or column.  Dense samples of other cells are skipped, so a sharded
+     worker produces only partial results: save them with SAVE_CHECKPOINT and
+     reduce them by a worker with MERGE_FILES.  STEP3 of a sharded worker
+     fails.  The prepass is computed by every shard.  */
+  int shard_row_begin, shard_row_end;
+  int shard_column_begin, shard_column_end;
 
   /* Prepare dimensions and the coarse prepass.  Return false for invalid
      settings or a cancellation request.  */
@@ -116,6 +144,10 @@ public:
   /* Robustly reduce dense samples and return the adaptive correction table.
      Return null on cancellation, invalid data, or tolerance failure.  */
   DLL_PUBLIC std::unique_ptr<scanner_blur_correction_parameters> step3 ();
+  /* Write all completed fits to CHECKPOINT_FILE.  STEP2 and STEP3 do so
+     automatically (also when cancelled), so this is only needed by callers
+     stopping between the stages.  Return false on write error.  */
+  DLL_PUBLIC bool save_checkpoint ();
   /* Aggregate profiling data from all completed prepass and dense fits.  */
   DLL_PUBLIC finetune_profile get_profile () const;
   /* Print a compact accumulated profile through the worker's progress output
@@ -170,11 +202,20 @@ private:
   }
 
   scanner_blur_correction_parameters::correction_mode mode;
+  /* Hash of the screen geometry and rendering parameters the analysis was
+     started with.  Checkpoints of other analyses are rejected.  */
+  uint64_t parameters_hash = 0;
   histogram red_hist;
   histogram green_hist;
   histogram blur_hist;
   std::vector<finetune_result> prepass;
   std::vector<finetune_result> mainpass;
+  /* Nonzero for fits which are complete and can be checkpointed.  */
+  std::vector<char> prepass_done;
+  std::vector<char> mainpass_done;
+  /* Protects the done flags and checkpoint writes.  */
+  std::mutex checkpoint_lock;
+  std::chrono::steady_clock::time_point last_checkpoint;
   coord_t focus_interpolation_max;
   coord_t focus_screen_frequency;
   std::string last_error;
@@ -182,6 +223,18 @@ private:
 
   /* Record and print one failure detected by a sequential worker stage.  */
   void set_error (const std::string &message);
+  /* Mark fit INDEX of the prepass (if PREPASS is true) or of the dense grid
+     as complete and write checkpoint if CHECKPOINT_INTERVAL elapsed.  */
+  void finish_fit (bool prepass, size_t index);
+  /* Write completed fits to CHECKPOINT_FILE; CHECKPOINT_LOCK must be held.  */
+  bool write_checkpoint ();
+  /* Load completed fits from file NAME; if OPTIONAL, missing file is not
+     an error.  */
+  bool load_checkpoint (const char *name, bool optional);
+  /* Return true if the dense pass is restricted to a subset of cells.  */
+  bool sharded_p () const;
+  /* Return true if table cell X,Y belongs to the shard.  */
+  bool in_shard_p (int x, int y) const;
 };
 } // namespace colorscreen
 #endif
@@ -63,6 +63,20 @@ public:
         e.sub[i] = sub;
   }
 
+  /* Return luminosity of CHANNEL in grid cell X, Y.  */
+  inline luminosity_t
+  get_luminosity (int x, int y, enum channel channel) const
+  {
+    return m_luminosities[y * m_width + x].lum[(int)channel];
+  }
+
+  /* Return black level of CHANNEL in grid cell X, Y.  */
+  inline luminosity_t
+  get_sub (int x, int y, enum channel channel) const
+  {
+    return m_luminosities[y * m_width + x].sub[(int)channel];
+  }
+
   /* Internal API.  */
   static std::shared_ptr <backlight_correction_parameters>
   load_captureone_lcc (memory_buffer *buf, bool verbose = false);
@@ -13,6 +13,7 @@
 namespace colorscreen
 {
 class scr_to_img;
+class screen_map;
 
 struct render_to_file_params
 {
@@ -132,6 +133,10 @@ struct tile_parameters
   int height;
   point_t pos;
   coord_t step;
+  /* If non-NULL, array of HEIGHT entries set to 1 for rows finished
+     (before cancellation) and 0 for rows not rendered.  Rendering the same
+     tile again reuses finished rows when possible.  */
+  uint8_t *completed_rows = nullptr;
 };
 
 struct color_match
@@ -181,13 +186,33 @@ struct has_regular_screen_ret
 nodiscard_attr DLL_PUBLIC struct has_regular_screen_ret
 has_regular_screen(image_data &scan, const has_regular_screen_params &params,
                    progress_info *progress = NULL);
+/* Save project to F.  If FILENAME is the name of F, large meshes and
+   solver point sets are written to binary sidecar file (FILENAME with .csp
+   replaced by .cspdata) by save_csp_data and only referenced from F.  */
 nodiscard_attr DLL_PUBLIC bool
 save_csp(FILE *f, const scr_to_img_parameters *param, const scr_detect_parameters *dparam,
-         const render_parameters *rparam, const solver_parameters *sparam);
+         const render_parameters *rparam, const solver_parameters *sparam,
+         const char *filename = NULL);
+/* Load project from F.  FILENAME, if non-NULL, is the name of F and is used
+   to locate the binary sidecar file F may refer to.  */
 nodiscard_attr DLL_PUBLIC bool
 load_csp(FILE *f, scr_to_img_parameters *param, scr_detect_parameters *dparam,
          render_parameters *rparam, solver_parameters *sparam,
-         const char **error);
+         const char **error, const char *filename = NULL);
+/* Save bulky project data to binary sidecar file FILENAME: mesh of PARAM,
+   points of SPARAM and screen map SMAP.  Any of them may be NULL.  Unlike
+   save_csp the data are stored exactly and can be memory mapped on load.  */
+nodiscard_attr DLL_PUBLIC bool
+save_csp_data(const char *filename, const scr_to_img_parameters *param,
+              const solver_parameters *sparam, const screen_map *smap,
+              const char **error);
+/* Load binary sidecar file FILENAME saved by save_csp_data.  Data present
+   in the file replace mesh of PARAM, points of SPARAM and SMAP unless they
+   are NULL.  */
+nodiscard_attr DLL_PUBLIC bool
+load_csp_data(const char *filename, scr_to_img_parameters *param,
+              solver_parameters *sparam, std::unique_ptr<screen_map> *smap,
+              const char **error);
 nodiscard_attr DLL_PUBLIC bool
 render_to_file(image_data &scan, scr_to_img_parameters &param,
                scr_detect_parameters &dparam, render_parameters &rparam,
@@ -198,6 +223,89 @@ render_tile(image_data &scan, scr_to_img_parameters &param,
             scr_detect_parameters &dparam, render_parameters &rparam,
             render_type_parameters &rtparam, tile_parameters &tile,
             progress_info *progress = NULL);
+
+struct tile_renderer_state;
+
+/* Renderer of individual tiles which keeps renderers with their
+   precomputed data alive between tiles rendered with the same parameters,
+   so rendering many small tiles does not pay setup cost for each of them.
+   The object is not thread safe; use one per thread.  */
+class tile_renderer
+{
+public:
+  DLL_PUBLIC tile_renderer ();
+  DLL_PUBLIC ~tile_renderer ();
+
+  /* Render TILE of SCAN with parameters same as render_tile.  */
+  nodiscard_attr DLL_PUBLIC bool
+  render (image_data &scan, scr_to_img_parameters &param,
+          scr_detect_parameters &dparam, render_parameters &rparam,
+          render_type_parameters &rtparam, tile_parameters &tile,
+          progress_info *progress = NULL);
+
+  /* Drop all renderers.  */
+  DLL_PUBLIC void clear ();
+
+  struct stats
+  {
+    /* Number of tiles rendered by existing and newly created renderers.  */
+    uint64_t reused, created;
+  };
+  /* Return statistics since construction or last clear.  */
+  DLL_PUBLIC stats get_stats () const;
+
+private:
+  std::unique_ptr<tile_renderer_state> m_state;
+};
+
+class view_tile_cache;
+
+/* Renderer of an interactive view.  The view is split into tiles of
+   TILE_SIZE x TILE_SIZE output pixels aligned to multiples of TILE_SIZE
+   at given scale.  Rendered tiles are cached, so panning renders only
+   the newly exposed tiles.  Tiles are kept for a few recently used
+   parameter sets, so reverting a parameter change does not render them
+   again.  */
+class view_renderer
+{
+public:
+  /* Size of tiles in output pixels.  */
+  static const int tile_size = 256;
+  /* Quick tiles are rendered with QUICK_SCALE times bigger step.  */
+  static const int quick_scale = 4;
+
+  /* Initialize renderer keeping at most MAX_TILES tiles.  */
+  DLL_PUBLIC view_renderer (size_t max_tiles = 512);
+  DLL_PUBLIC ~view_renderer ();
+
+  /* Render VIEW of SCAN with parameters same as render_tile.  If QUICK
+     is true, tiles not yet in the cache are rendered at lower resolution
+     and a later call with QUICK false refines them.  If COMPLETE is
+     non-NULL, set it to true if all tiles of VIEW are at full
+     resolution.  */
+  nodiscard_attr DLL_PUBLIC bool
+  render (image_data &scan, scr_to_img_parameters &param,
+          scr_detect_parameters &dparam, render_parameters &rparam,
+          render_type_parameters &rtparam, tile_parameters &view, bool quick,
+          bool *complete = NULL, progress_info *progress = NULL);
+
+  /* Drop all cached tiles.  */
+  DLL_PUBLIC void clear ();
+
+  struct stats
+  {
+    /* Number of tiles taken from the cache.  */
+    uint64_t hits;
+    /* Number of tiles rendered at full and low resolution.  */
+    uint64_t rendered, quick_rendered;
+  };
+  /* Return statistics since construction or last clear.  */
+  DLL_PUBLIC stats get_stats () const;
+
+private:
+  std::unique_ptr<view_tile_cache> m_cache;
+};
+
 enum render_screen_tile_type
 {
   original_screen,
@@ -224,6 +332,13 @@ complete_rendered_file_parameters(render_type_parameters *rtparams,
                                   scr_to_img_parameters *param,
                                   image_data *scan, stitch_project *stitch,
                                   render_to_file_params *p);
+/* If HALF is true, store large intermediate luminosity buffers (linearized
+   and sharpened scan data) as 16bit half floats.  This halves their memory
+   footprint and bandwidth for about 3 significant decimal digits of
+   precision.  Affects data computed after the call.  */
+DLL_PUBLIC void set_half_float_storage (bool half);
+/* Return true if large intermediate buffers are stored as half floats.  */
+DLL_PUBLIC bool half_float_storage_p ();
 DLL_PUBLIC rgbdata get_linearized_pixel(const image_data &img,
                                         render_parameters &rparam, int x, int y,
                                         int range = 4,
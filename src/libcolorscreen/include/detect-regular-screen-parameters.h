@@ -16,7 +16,8 @@ struct detect_regular_screen_params
         left (false), right (false), lens_correction (),
         min_patch_contrast (2), max_unknown_screen_range (10000),
         optimize_colors (true), slow_floodfill (true), fast_floodfill (true),
-        return_known_patches (false), return_screen_map (false), do_mesh (true)
+        return_known_patches (false), return_screen_map (false), do_mesh (true),
+        flood_fill_tile_size (2048)
   {
   }
 
@@ -39,6 +40,9 @@ struct detect_regular_screen_params
   bool return_known_patches;
   bool return_screen_map;
   bool do_mesh;
+  /* Scans larger than FLOOD_FILL_TILE_SIZE pixels are flood filled in
+     parallel from one region per tile.  0 disables the parallel flood fill.  */
+  int flood_fill_tile_size;
 };
 /* Invormation about auto-detected screen.
    If mesh_trans is NULL the detection failed.  */
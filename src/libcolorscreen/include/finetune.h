@@ -80,7 +80,10 @@ enum finetune_flags : uint64_t
      dim the red, green and blue screen primaries before capture blur.  This
      is intended for joint focus analysis of several differently coloured
      solid areas.  */
-  finetune_uniform_image_layer = 1 << 22
+  finetune_uniform_image_layer = 1 << 22,
+  /* Use BFGS optimizer with finite difference gradients (evaluated in
+     parallel when possible) instead of Nelder-Mead simplex.  */
+  finetune_bfgs = 1 << 23
 };
 
 /* Lightweight counters collected by FINETUNE.  Times use steady-clock
@@ -109,6 +112,7 @@ struct finetune_profile
   uint64_t focus_screen_interpolations = 0;
   uint64_t focus_screen_exact_node_uses = 0;
   uint64_t focus_screen_final_exact_builds = 0;
+  uint64_t spectral_screen_blurs = 0;
   uint64_t exact_screen_builds = 0;
 
   uint64_t mtf_precompute_calls = 0;
@@ -151,6 +155,7 @@ struct finetune_profile
     focus_screen_interpolations += o.focus_screen_interpolations;
     focus_screen_exact_node_uses += o.focus_screen_exact_node_uses;
     focus_screen_final_exact_builds += o.focus_screen_final_exact_builds;
+    spectral_screen_blurs += o.spectral_screen_blurs;
     exact_screen_builds += o.exact_screen_builds;
     mtf_precompute_calls += o.mtf_precompute_calls;
     mtf_psf_precompute_calls += o.mtf_psf_precompute_calls;
@@ -349,6 +354,12 @@ struct finetune_area_parameters
   /* Maximum accepted registration displacement in screen-period units.  A
      meaningful range is approximately 0 to 0.2.  */
   luminosity_t max_displacement = 0.05;
+  /* Start fits from offsets and blur of already solved neighbouring tiles
+     (solving a coarse grid first).  Tiles whose warm started fit is not
+     usable are solved again from the default starting point.  */
+  bool warm_start = true;
+  /* If non-NULL, profiles of all individual fits are accumulated here.  */
+  finetune_profile *profile = nullptr;
 
   /* Determine grid WIDTH and HEIGHT for CROP and PARAM.  */
   void
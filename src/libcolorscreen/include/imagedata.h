@@ -50,29 +50,29 @@ public:
   get_pixel (uint32_t x, unsigned int y) const
   {
     if (colorscreen_checking)
-      assert (x >= 0 && (int)x < width && y >= 0 && (int)y < height);
-    return *(m_data + y * (uint64_t)width + x);
+      assert (x >= 0 && (int)x < width && row_available_p (y));
+    return *(m_data + row_offset (y) + x);
   }
   inline void
   put_pixel (uint32_t x, unsigned int y, gray val)
   {
     if (colorscreen_checking)
-      assert ((int)x >= 0 && (int)x < width && y >= 0 && (int)y < height);
-    *(m_data + y * (uint64_t)width + x) = val;
+      assert ((int)x >= 0 && (int)x < width && row_available_p (y));
+    *(m_data + row_offset (y) + x) = val;
   }
   inline gray *
   get_row (uint32_t y)
   {
     if (colorscreen_checking)
-      assert ((int)y >= 0 && (int)y < height);
-    return m_data ? m_data + y * (uint64_t)width : nullptr;
+      assert (row_available_p (y));
+    return m_data ? m_data + row_offset (y) : nullptr;
   }
   inline const gray *
   get_row (uint32_t y) const
   {
     if (colorscreen_checking)
-      assert ((int)y >= 0 && (int)y < height);
-    return m_data ? m_data + y * (uint64_t)width : nullptr;
+      assert (row_available_p (y));
+    return m_data ? m_data + row_offset (y) : nullptr;
   }
 
   /* RGB scan API.  */
@@ -80,32 +80,33 @@ public:
   get_rgb_pixel (uint32_t x, unsigned int y) const
   {
     if (colorscreen_checking)
-      assert ((int)x >= 0 && (int)x < width && (int)y >= 0 && (int)y < height);
-    return *(m_rgbdata+ y * (uint64_t)width + x);
+      assert ((int)x >= 0 && (int)x < width && row_available_p (y));
+    return *(m_rgbdata + row_offset (y) + x);
   }
   inline void
   put_rgb_pixel (uint32_t x, unsigned int y, pixel val)
   {
     if (colorscreen_checking)
-      assert ((int)x >= 0 && (int)x < width && (int)y >= 0 && (int)y < height);
-    *(m_rgbdata + y * (uint64_t)width + x) = val;
+      assert ((int)x >= 0 && (int)x < width && row_available_p (y));
+    *(m_rgbdata + row_offset (y) + x) = val;
   }
   inline pixel *
   get_rgb_row (uint32_t y)
   {
     if (colorscreen_checking)
-      assert ((int)y >= 0 && (int)y < height);
-    return m_rgbdata ? m_rgbdata + y * (uint64_t)width : nullptr;
+      assert (row_available_p (y));
+    return m_rgbdata ? m_rgbdata + row_offset (y) : nullptr;
   }
   inline const pixel *
   get_rgb_row (uint32_t y) const
   {
     if (colorscreen_checking)
-      assert ((int)y >= 0 && (int)y < height);
-    return m_rgbdata ? m_rgbdata + y * (uint64_t)width : nullptr;
+      assert (row_available_p (y));
+    return m_rgbdata ? m_rgbdata + row_offset (y) : nullptr;
   }
 
-  /* Raw data access (legacy/performance).  */
+  /* Raw data access (legacy/performance).  In streaming mode the pointers
+     point to the first row kept in memory.  */
   inline gray *
   get_data_ptr ()
   {
@@ -146,13 +147,22 @@ public:
   /* Beginning of the viewport of stitched object.  */
   int xmin = 0, ymin = 0;
 
+  /* Factor the image was downscaled by while loading.  JPEG files are
+     decoded with DCT scaling, JPEG 2000 files by discarding resolution
+     levels (if the codestream has enough of them) and RAW files using half
+     size decoding and binning.  Other formats are always loaded in full
+     resolution.  */
+  int load_scale = 1;
+
   /* Initialize loader for NAME.  Return true on success.
      If false is returned ERROR is initialized to error
-     message.  */
+     message.  SCALE (1, 2, 4 or 8) requests image downscaled by given
+     factor; see load_scale.  */
   nodiscard_attr DLL_PUBLIC bool init_loader (const char *name, bool preload_all,
 					      const char **error,
 					      progress_info *progress = NULL,
-					      demosaicing_t demosaic = demosaic_default);
+					      demosaicing_t demosaic = demosaic_default,
+					      int scale = 1);
   /* True if grayscale allocation is needed
      (used after init_loader and before load_part).  */
   nodiscard_attr DLL_PUBLIC bool allocate_grayscale ();
@@ -167,10 +177,43 @@ public:
 
   /* Allocate memory.  */
   nodiscard_attr DLL_PUBLIC bool allocate ();
-  /* Load image data from file with auto-detection.  */
+
+  /* Streaming (out-of-core) access.  It can be used instead of allocate and
+     load_part after init_loader.  Only a band of consecutive rows is kept in
+     memory; ROWS is the initial size of the band.  Supported only by loaders
+     which produce rows in order.  */
+  nodiscard_attr DLL_PUBLIC bool allocate_rows (int rows, const char **error,
+					       progress_info *progress = NULL);
+  /* Make rows FIRST...LAST-1 available.  Rows before FIRST are dropped and
+     can not be loaded again; the band is enlarged if needed.
+     If false is returned ERROR is initialized.  */
+  nodiscard_attr DLL_PUBLIC bool load_rows (int first, int last,
+					   const char **error,
+					   progress_info *progress = NULL);
+  /* Initialize loader for NAME and prepare streaming access with band
+     of ROWS rows.  */
+  nodiscard_attr DLL_PUBLIC bool load_streaming (const char *name, int rows,
+						const char **error,
+						progress_info *progress = NULL);
+  /* Return true if only band of rows is kept in memory.  */
+  pure_attr inline bool
+  streaming_p () const
+  {
+    return m_band_rows;
+  }
+  /* Return number of rows the band can hold.  */
+  pure_attr inline int
+  band_rows () const
+  {
+    return m_band_rows;
+  }
+  /* Load image data from file with auto-detection.  SCALE (1, 2, 4 or 8)
+     requests fast load of image downscaled by given factor.  It is useful
+     for previews and overviews.  */
   nodiscard_attr DLL_PUBLIC bool load (const char *name, bool preload_all, const char **error,
 				       progress_info *progress = NULL,
-				       demosaicing_t demosaic = demosaic_default);
+				       demosaicing_t demosaic = demosaic_default,
+				       int scale = 1);
   /* Set dimensions of the image.  This can be used to produce image_data
      without loading it.  */
   nodiscard_attr DLL_PUBLIC bool set_dimensions (int w, int h, bool allocate_rgb = false,
@@ -217,6 +260,27 @@ private:
 
   bool parse_icc_profile (progress_info *);
 
+  /* Streaming state.  M_BAND_ROWS is 0 if whole image is in memory.
+     Otherwise rows M_FIRST_ROW...M_LOADED_ROWS-1 are kept in buffers holding
+     M_BAND_ROWS rows.  */
+  int m_band_rows = 0;
+  int m_first_row = 0;
+  int m_loaded_rows = 0;
+
+  /* Return offset of row Y in data buffers.  */
+  pure_attr inline uint64_t
+  row_offset (unsigned int y) const
+  {
+    return (y - m_first_row) * (uint64_t)width;
+  }
+  /* Return true if row Y is in memory (or being loaded).  */
+  pure_attr inline bool
+  row_available_p (unsigned int y) const
+  {
+    return (int)y >= m_first_row && (int)y < height
+	   && (!m_band_rows || (int)y < m_first_row + m_band_rows);
+  }
+
   /* Grayscale scan.  */
   gray *m_data = nullptr;
   /* Optional color scan.  */
@@ -8,6 +8,8 @@
 
 namespace colorscreen
 {
+class binary_writer;
+class binary_reader;
 
 /* Class implementing 2D mesh transformation.  It maps image coordinates
    to screen coordinates and vice versa using bilinear interpolation.  */
@@ -97,6 +99,15 @@ public:
     return { np.x, np.y };
   }
 
+  /* Apply mesh transformation to N points IN and store result to OUT.
+     IN and OUT may be the same array.  */
+  void
+  apply (const point_t *in, point_t *out, int n) const
+  {
+    for (int i = 0; i < n; i++)
+      out[i] = apply (in[i]);
+  }
+
   /* Return true if X, Y are in the range covered by mesh.  */
   bool
   in_range_p (coord_t x, coord_t y) const
@@ -187,6 +198,13 @@ public:
   /* Load mesh content from file F. Store description of error in ERROR if any.  */
   static std::unique_ptr <mesh> load (FILE *f, const char **error);
 
+  /* Save mesh content to binary sidecar writer W.  */
+  void save_binary (binary_writer &w) const;
+
+  /* Load mesh content from binary sidecar reader R.  Store description of
+     error in ERROR if any.  */
+  static std::unique_ptr <mesh> load_binary (binary_reader &r, const char **error);
+
   /* Unique id of the mesh (used for caching).  */
   uint64_t id;
 
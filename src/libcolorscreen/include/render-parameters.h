@@ -823,6 +823,29 @@ struct render_parameters
   {
     return !(*this == other);
   }
+
+  /* Stages of the rendering pipeline.  Later stages consume the results of
+     earlier ones, so invalidating a stage invalidates all stages after it.  */
+  enum render_stage
+  {
+    /* Nothing needs to be recomputed.  */
+    render_stage_none,
+    /* Only the conversion of linear process RGB to the output (color matrix,
+       saturation, tone curve, output gamma and profile) needs to be redone.
+       This is the stage implemented by out_color_adjustments.  */
+    render_stage_output,
+    /* Geometry sampling, interpolation and everything after it needs to be
+       redone.  */
+    render_stage_all
+  };
+
+  /* Return the earliest stage of the rendering pipeline which needs to be
+     recomputed when rendering parameters change from OTHER to THIS.  */
+  pure_attr DLL_PUBLIC render_stage
+  invalidated_stage (const render_parameters &other) const;
+
+  /* Copy parameters consumed only by the output stage from OTHER.  */
+  DLL_PUBLIC void copy_output_parameters (const render_parameters &other);
   /* Set exposure and dark_point for a given range of values
      in input scan.  Used to interpret old gray_range parameter
      and can be removed eventually.
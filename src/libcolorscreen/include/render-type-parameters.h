@@ -1,5 +1,6 @@
 #ifndef RENDER_TYPE_PARAMETERS_H
 #define RENDER_TYPE_PARAMETERS_H
+#include "base.h"
 namespace colorscreen
 {
 enum render_type_t
@@ -65,10 +66,27 @@ public:
   enum render_type_t type;
   bool color;
   bool antialias;
+  /* If positive, renderers may replace the exact mapping between image
+     and screen coordinates by a piecewise bilinear approximation which
+     differs by at most this many image pixels.  */
+  coord_t coordinate_error;
   render_type_parameters ()
-      : type (render_type_original), color (true), antialias (true)
+      : type (render_type_original), color (true), antialias (true),
+        coordinate_error (0)
   {
   }
+  bool
+  operator== (const render_type_parameters &other) const
+  {
+    return type == other.type && color == other.color
+           && antialias == other.antialias
+           && coordinate_error == other.coordinate_error;
+  }
+  bool
+  operator!= (const render_type_parameters &other) const
+  {
+    return !(*this == other);
+  }
 };
 }
 #endif
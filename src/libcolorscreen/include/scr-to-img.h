@@ -153,6 +153,17 @@ public:
       }
     return p;
   }
+  /* Map N screen coordinates IN to image coordinates OUT.  IN and OUT
+     may be the same array.  The result is the same as calling to_img
+     for every point (up to few ULPs if the compiler contracts to fused
+     multiply-adds differently); the choice between mesh, lens correction
+     and plain homography is done once for the whole batch so the common
+     cases vectorize.  */
+  DLL_PUBLIC void to_img (const point_t *in, point_t *out, int n) const noexcept;
+  /* Map N image coordinates IN to screen coordinates OUT.  IN and OUT
+     may be the same array.  Equivalent to calling to_scr for every
+     point.  */
+  DLL_PUBLIC void to_scr (const point_t *in, point_t *out, int n) const noexcept;
   pure_attr inline point_t
   scr_to_final (point_t p) const noexcept
   {
@@ -10,6 +10,8 @@ namespace colorscreen
 {
 class scr_to_img;
 class image_data;
+class binary_writer;
+class binary_reader;
 class screen_map
 {
 public:
@@ -136,6 +138,8 @@ public:
   bool grow (bool left, bool right, bool top, bool bottom);
   void get_known_range (int *xminr, int *yminr, int *xmaxr, int *ymaxr);
   void determine_solver_points (int patches_found, solver_parameters *sparam) const;
+  void save_binary (binary_writer &w) const;
+  static std::unique_ptr<screen_map> load_binary (binary_reader &r, const char **error);
 
   enum scr_type type;
   int width, height, xshift, yshift;
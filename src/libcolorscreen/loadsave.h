@@ -1,6 +1,8 @@
 #ifndef LOADSAVE_H
 #define LOADSAVE_H
 #include <stdio.h>
+#include <cstdint>
+#include <cstddef>
 #include <include/base.h>
 namespace colorscreen
 {
@@ -8,5 +10,128 @@ bool expect_keyword (FILE *f, const char *);
 bool parse_bool (FILE *f, bool *val);
 bool read_scalar (FILE *f, coord_t *);
 void get_keyword (FILE *f, char *buf);
+
+/* Binary sidecar files holding bulky project data (meshes, solver points
+   and screen maps) which are slow to parse and lose precision in the text
+   format.
+
+   The file starts with 8 byte magic "CSPDATA\0", 32bit version and 32bit
+   reserved word.  It is followed by chunks.  Every chunk starts with
+   4 character tag, 32bit reserved word and 64bit size of payload.  Payload
+   is padded by zeros to a multiple of 8 bytes, so all values are naturally
+   aligned when the file is memory mapped.  All numbers are little-endian,
+   floating point values are IEEE single or double precision.  Readers skip
+   chunks with unknown tags.  */
+constexpr uint32_t csp_data_version = 1;
+
+/* Writer of binary sidecar files.  Write errors are remembered and reported
+   by ok.  */
+class binary_writer
+{
+public:
+  binary_writer (FILE *f)
+  : m_f (f), m_chunk_start (-1), m_ok (true)
+  { }
+  /* Write file header.  */
+  void put_header ();
+  /* Start chunk with TAG.  Chunks can not be nested.  */
+  void begin_chunk (const char *tag);
+  /* Finish chunk: pad it and fill in its size.  */
+  void end_chunk ();
+  void put_u32 (uint32_t v);
+  void
+  put_i32 (int32_t v)
+  {
+    put_u32 ((uint32_t)v);
+  }
+  void put_u64 (uint64_t v);
+  void put_f32 (float v);
+  void put_f64 (double v);
+  /* Return true if all writes succeeded.  */
+  bool
+  ok () const
+  {
+    return m_ok;
+  }
+
+private:
+  FILE *m_f;
+  int64_t m_chunk_start;
+  bool m_ok;
+  void put_bytes (const unsigned char *data, size_t n);
+};
+
+/* Reader of SIZE bytes of binary sidecar data starting at DATA.  All reads
+   are bounds checked and return false at the end of data.  */
+class binary_reader
+{
+public:
+  binary_reader (const unsigned char *data, size_t size)
+  : m_data (data), m_size (size), m_pos (0)
+  { }
+  /* Return pointer to next N bytes and skip them or return NULL.  */
+  const unsigned char *
+  get_raw (uint64_t n)
+  {
+    if (m_size - m_pos < n)
+      return NULL;
+    const unsigned char *ret = m_data + m_pos;
+    m_pos += n;
+    return ret;
+  }
+  bool get_u32 (uint32_t *v);
+  bool
+  get_i32 (int32_t *v)
+  {
+    uint32_t u;
+    if (!get_u32 (&u))
+      return false;
+    *v = (int32_t)u;
+    return true;
+  }
+  bool get_u64 (uint64_t *v);
+  bool get_f32 (float *v);
+  bool get_f64 (double *v);
+  /* Return number of bytes not read yet.  */
+  size_t
+  remaining () const
+  {
+    return m_size - m_pos;
+  }
+
+private:
+  const unsigned char *m_data;
+  size_t m_size, m_pos;
+};
+
+/* Read-only contents of a file.  It is memory mapped where supported and
+   read to memory otherwise.  */
+class mapped_file
+{
+public:
+  mapped_file ()
+  : m_data (NULL), m_size (0), m_mapped (false)
+  { }
+  ~mapped_file ();
+  mapped_file (const mapped_file &) = delete;
+  mapped_file &operator= (const mapped_file &) = delete;
+  /* Open FILENAME.  Store description of error to ERROR on failure.  */
+  bool open (const char *filename, const char **error);
+  const unsigned char *
+  data () const
+  {
+    return m_data;
+  }
+  size_t
+  size () const
+  {
+    return m_size;
+  }
+
+private:
+  const unsigned char *m_data;
+  size_t m_size;
+  bool m_mapped;
+};
 }
 #endif
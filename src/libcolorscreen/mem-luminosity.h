@@ -1,53 +1,49 @@
 #ifndef MEM_LUMINOSITY_H
 #define MEM_LUMINOSITY_H
 #include "config.h"
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
 namespace colorscreen
 {
-#ifndef COLORSCREEN_16BIT_FLOAT
-typedef float mem_luminosity_t;
-#else
-/* mem_luminosity_t is used for very large temporary data.  */
-
-#if 0
-#ifdef __x86_64__
-typedef _Float16 mem_luminosity_t;
-#elif __aarch64__
-typedef __fp16 mem_luminosity_t;
-#else
-#warning 16bit data type not available
-typedef float mem_luminosity_t;
-#endif
-
-#else
-
-/* Open coded implementation seems to work faster than Float16 on x86_64 so far.
-   based on https://www.researchgate.net/publication/362275548_Accuracy_and_performance_of_the_lattice_Boltzmann_method_with_64-bit_32-bit_and_customized_16-bit_number_formats  */
-struct mem_luminosity_t
+/* 16bit half float used to store very large temporary data.
+   Open coded implementation seems to work faster than Float16 on x86_64 so far.
+   based on https://www.researchgate.net/publication/362275548_Accuracy_and_performance_of_the_lattice_Boltzmann_method_with_64-bit_32-bit_and_customized_16-bit_number_formats
+   If the target has F16C, the hardware conversion is used instead.  */
+struct half_luminosity_t
 {
   uint16_t x;
 
-  constexpr mem_luminosity_t ()
+  constexpr half_luminosity_t ()
   : x (0)
   { }
 
   /* Testsuite reproduces undefined shift, but it is multiplied by 0.  */
   __attribute__((no_sanitize("undefined")))
   always_inline_attr inline
-  mem_luminosity_t (float y)
+  half_luminosity_t (float y)
   {
+#ifdef __F16C__
+    x = _cvtss_sh (y, _MM_FROUND_TO_NEAREST_INT);
+#else
     const unsigned int b = as_uint(y)+0x00001000; // round-to-nearest-even: add last bit after truncated mantissa
     const unsigned int e = (b&0x7F800000)>>23; // exponent
     const unsigned int m = b&0x007FFFFF; // mantissa; in line below: 0x007FF000 = 0x00800000-0x00001000 = decimal indicator flag - initial rounding
     x = (b&0x80000000)>>16 | (e>112)*((((e-112)<<10)&0x7C00)|m>>13) | ((e<113)&(e>101))*((((0x007FF000+m)>>(125-e))+1)>>1) | (e>143)*0x7FFF; // sign : normalized : denormalized : saturate
+#endif
   }
   __attribute__((no_sanitize("undefined")))
   always_inline_attr inline const_attr
   operator float () const
   {
+#ifdef __F16C__
+    return _cvtsh_ss (x);
+#else
     const unsigned int e = (x&0x7C00)>>10; // exponent
     const unsigned int m = (x&0x03FF)<<13; // mantissa
     const unsigned int v = as_uint((float)m)>>23; // evil log2 bit hack to count leading zeros in denormalized format
     return as_float((x&0x8000)<<16 | (e!=0)*((e+112)<<23|m) | ((e==0)&(m!=0))*((v-37)<<23|((m<<(150-v))&0x007FE000))); // sign : normalized : denormalized
+#endif
   }
   always_inline_attr inline const_attr
   operator double () const
@@ -68,8 +64,68 @@ private:
     return v.f;
   }
 };
+
+#ifndef COLORSCREEN_16BIT_FLOAT
+typedef float mem_luminosity_t;
+#else
+/* mem_luminosity_t is used for very large temporary data.  */
+typedef half_luminosity_t mem_luminosity_t;
 #endif
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__F16C__)
+/* F16C instructions are not enabled for the whole build, but are used by
+   functions compiled for them when the CPU supports them.  */
+#define COLORSCREEN_RUNTIME_F16C
 #endif
+
+/* Convert N floats IN to half floats OUT.  Use F16C instructions if the CPU
+   supports them.  */
+void floats_to_halves (half_luminosity_t *out, const float *in, size_t n);
+
+/* Convert N half floats IN to floats OUT.  Use F16C instructions if the CPU
+   supports them.  */
+void halves_to_floats (float *out, const half_luminosity_t *in, size_t n);
+
+/* Pointer to a large buffer of luminosities which is stored either as floats
+   or as half floats.  The storage is selected at runtime, see
+   set_half_float_storage.  */
+struct mem_luminosity_ptr
+{
+  float *f = nullptr;
+  half_luminosity_t *h = nullptr;
+
+  /* Return luminosity at index I.  */
+  pure_attr inline luminosity_t
+  operator[] (size_t i) const
+  {
+    if (h)
+      return h[i];
+    return f[i];
+  }
+
+  /* Set luminosity at index I to V.  */
+  inline void
+  set (size_t i, luminosity_t v)
+  {
+    if (h)
+      h[i] = v;
+    else
+      f[i] = v;
+  }
+
+  /* Return size of one element in bytes.  */
+  pure_attr size_t
+  element_size () const
+  {
+    return h ? sizeof (half_luminosity_t) : sizeof (float);
+  }
+
+  explicit operator bool () const
+  {
+    return f || h;
+  }
+};
+
 /* Datastructure used to store information about dye luminosities.  */
 struct mem_rgbdata
 {
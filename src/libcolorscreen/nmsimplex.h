@@ -1,3 +1,5 @@
+#ifndef NMSIMPLEX_H
+#define NMSIMPLEX_H
 /* Based on nmsimplex.c by Michael F. Hutt used by dcamprof.  */
 
 namespace colorscreen
@@ -380,3 +382,4 @@ simplex (C &c, const char *task = NULL, progress_info *progress = NULL, bool pro
   return min;
 }
 }
+#endif
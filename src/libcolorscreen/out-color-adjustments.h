@@ -48,6 +48,20 @@ public:
   /* Compute color in the final output gamma for values in C.  */
   pure_attr inline rgbdata hdr_final_color (rgbdata c) const noexcept;
 
+  /* Return NORMALIZED_PATCHES passed to last precompute.  */
+  pure_attr bool
+  normalized_patches_p () const noexcept
+  {
+    return m_normalized_patches;
+  }
+
+  /* Return PATCH_PROPORTIONS passed to last precompute.  */
+  pure_attr rgbdata
+  patch_proportions () const noexcept
+  {
+    return m_patch_proportions;
+  }
+
   static constexpr const size_t out_lookup_table_size = 65536 * 16;
 
   /* Color matrix.  For additive processes it converts process RGB to prophoto
@@ -65,6 +79,13 @@ private:
   luminosity_t m_output_gamma = (luminosity_t)-1.0;
   bool m_gamut_warning = false;
 
+  /* Arguments of last precompute.  They are needed to redo the output stage
+     for different render parameters without re-running the renderer.  */
+  bool m_normalized_patches = false;
+  rgbdata m_patch_proportions = { (luminosity_t)1.0 / (luminosity_t)3.0,
+				  (luminosity_t)1.0 / (luminosity_t)3.0,
+				  (luminosity_t)1.0 / (luminosity_t)3.0 };
+
   /* Tone curve translation.  */
   std::unique_ptr<tone_curve> m_tone_curve = nullptr;
 
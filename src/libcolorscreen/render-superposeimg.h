@@ -3,6 +3,7 @@
 #include <assert.h>
 #include "render-to-scr.h"
 #include "screen.h"
+#include "coordinate-grid.h"
 namespace colorscreen
 {
 class render_superpose_img : public render_to_scr
@@ -11,13 +12,14 @@ public:
   inline render_superpose_img (scr_to_img_parameters &param, image_data &data,
                                render_parameters &rparam, int dst_maxval)
       : render_to_scr (param, data, rparam, dst_maxval), m_screen (),
-        m_color (false), m_preview (false)
+        m_color (false), m_preview (false), m_coordinate_error (0)
   {
   }
   void
   set_render_type (render_type_parameters rtparam)
   {
     m_preview = (rtparam.type == render_type_preview_grid);
+    m_coordinate_error = rtparam.coordinate_error;
     if (rtparam.color)
       set_color_display ();
   }
@@ -31,6 +33,15 @@ public:
   }
   bool
   precompute_all (progress_info *progress)
+  {
+    return precompute_img_range ({ 0, 0, m_img.width, m_img.height },
+                                 progress);
+  }
+  /* Precompute rendering of image area AREA.  The screen is the same
+     everywhere, but the approximation of coordinate mapping is built
+     only for AREA.  */
+  bool
+  precompute_img_range (int_image_area area, progress_info *progress = NULL)
   {
     sharpen_parameters sharpen;
     if (!m_preview)
@@ -48,13 +59,10 @@ public:
     int flags = m_color ? PRECOMPUTE_RGB_IMAGE : PRECOMPUTE_IMAGE_LAYER;
     if (m_preview)
       flags |= NORMALIZED_PATCHES;
-    return render_to_scr::precompute_all (flags, progress);
-  }
-  bool
-  precompute_img_range (int_image_area area, progress_info *progress = NULL)
-  {
-    (void)area;
-    return precompute_all (progress);
+    if (!render_to_scr::precompute_img_range (flags, area, progress))
+      return false;
+    init_coordinate_grid (area);
+    return true;
   }
   inline rgbdata sample_pixel_img (point_t p) const;
   void inline analyze_tile (int x, int y, int w, int h, int stepx, int stepy,
@@ -87,9 +95,41 @@ public:
 private:
   pure_attr inline rgbdata
   sample_pixel_img (point_t p, point_t scr) const;
+  /* If approximate coordinates are permitted, build M_TO_SCR_GRID
+     for image area AREA.  */
+  void
+  init_coordinate_grid (int_image_area area)
+  {
+    m_to_scr_grid.clear ();
+    if (!(m_coordinate_error > 0) || area.empty_p ())
+      return;
+    area = area.intersect ({ 0, 0, m_img.width, m_img.height });
+    if (area.empty_p ())
+      return;
+    /* The bound is given in image pixels while the grid approximates
+       screen coordinates.  If the mapping is too wild to meet the bound,
+       the grid stays uninitialized and exact mapping is used.  */
+    m_to_scr_grid.init ([this] (point_t p) { return m_scr_to_img.to_scr (p); },
+                        { (coord_t)area.x, (coord_t)area.y,
+                          (coord_t)area.width, (coord_t)area.height },
+                        m_coordinate_error * pixel_size ());
+  }
+  /* Map image coordinates P to screen coordinates, possibly using
+     the approximation.  */
+  pure_attr inline point_t
+  img_to_scr (point_t p) const
+  {
+    if (m_to_scr_grid.in_range_p (p))
+      return m_to_scr_grid.apply (p);
+    return m_scr_to_img.to_scr (p);
+  }
   std::shared_ptr<screen> m_screen;
   bool m_color;
   bool m_preview;
+  /* Permitted error of coordinate approximation in image pixels.  */
+  coord_t m_coordinate_error;
+  /* Approximation of M_SCR_TO_IMG.to_scr; unused if not initialized.  */
+  coordinate_grid m_to_scr_grid;
 };
 
 inline rgbdata
@@ -99,7 +139,7 @@ render_superpose_img::fast_sample_pixel_img (int_point_t p) const
   luminosity_t ra, ga, ba;
 
   int ix, iy;
-  point_t scr = m_scr_to_img.to_scr ({ p.x + (coord_t)0.5, p.y + (coord_t)0.5 });
+  point_t scr = img_to_scr ({ p.x + (coord_t)0.5, p.y + (coord_t)0.5 });
 
   ix = (uint64_t)nearest_int (scr.x * screen::size)
        & (unsigned)(screen::size - 1);
@@ -175,46 +215,76 @@ render_superpose_img::sample_pixel_img (point_t p, point_t scr) const
 pure_attr inline rgbdata
 render_superpose_img::sample_pixel_img (point_t p) const
 {
-  point_t scr = m_scr_to_img.to_scr (p);
+  point_t scr = img_to_scr (p);
   return sample_pixel_img (p, scr);
 }
 
 /* Analyze average r, g and b color in a given tile in the image coordinates.
- */
+   XS, YS, W and H specify the tile, every STEPX-th column of every STEPY-th
+   row is sampled.  Averages are stored to R, G and B.  */
 inline void
 render_superpose_img::analyze_tile (int xs, int ys, int w, int h, int stepx,
                                     int stepy, luminosity_t *r,
                                     luminosity_t *g, luminosity_t *b)
 {
-  luminosity_t rw = 0, rr = 0, gw = 0, gg = 0, bw = 0, bb = 0;
-  for (int x = xs; x < xs + w; x += stepx)
-    for (int y = ys; y < ys + h; y += stepy)
+  /* Sums over large tiles lose too much precision in single precision.  */
+  double rw = 0, rr = 0, gw = 0, gg = 0, bw = 0, bb = 0;
+  int xsteps = (w + stepx - 1) / stepx;
+  int ysteps = (h + stepy - 1) / stepy;
+  /* Walk the image in row-major order so pixel fetches are sequential;
+     screen coordinates of a whole row are computed by a single batch
+     call.  */
+#pragma omp parallel default(none)                                           \
+    shared(xs, ys, stepx, stepy, xsteps, ysteps)                              \
+    reduction(+ : rw, rr, gw, gg, bw, bb)                                     \
+    if (xsteps * (int64_t)ysteps > 65536)
+  {
+    std::vector<point_t> scr_row (xsteps);
+#pragma omp for
+    for (int sy = 0; sy < ysteps; sy++)
       {
-        luminosity_t l = fast_get_img_pixel ({x, y});
-
-        point_t scr
-            = m_scr_to_img.to_scr ({ x + (coord_t)0.5, y + (coord_t)0.5 });
-        int ix = (uint64_t)nearest_int (scr.x * screen::size)
-                 & (unsigned)(screen::size - 1);
-        int iy = (uint64_t)nearest_int (scr.y * screen::size)
-                 & (unsigned)(screen::size - 1);
-        rr += m_screen->mult[iy][ix][0] * l;
-        rw += m_screen->mult[iy][ix][0];
-        gg += m_screen->mult[iy][ix][1] * l;
-        gw += m_screen->mult[iy][ix][1];
-        bb += m_screen->mult[iy][ix][2] * l;
-        bw += m_screen->mult[iy][ix][2];
+        int y = ys + sy * stepy;
+        for (int sx = 0; sx < xsteps; sx++)
+          scr_row[sx] = { xs + sx * stepx + (coord_t)0.5, y + (coord_t)0.5 };
+        if (m_to_scr_grid.initialized_p ())
+          for (int sx = 0; sx < xsteps; sx++)
+            scr_row[sx] = img_to_scr (scr_row[sx]);
+        else
+          m_scr_to_img.to_scr (scr_row.data (), scr_row.data (), xsteps);
+        luminosity_t lrw = 0, lrr = 0, lgw = 0, lgg = 0, lbw = 0, lbb = 0;
+        for (int sx = 0; sx < xsteps; sx++)
+          {
+            luminosity_t l = fast_get_img_pixel ({ xs + sx * stepx, y });
+            point_t scr = scr_row[sx];
+            int ix = (uint64_t)nearest_int (scr.x * screen::size)
+                     & (unsigned)(screen::size - 1);
+            int iy = (uint64_t)nearest_int (scr.y * screen::size)
+                     & (unsigned)(screen::size - 1);
+            lrr += m_screen->mult[iy][ix][0] * l;
+            lrw += m_screen->mult[iy][ix][0];
+            lgg += m_screen->mult[iy][ix][1] * l;
+            lgw += m_screen->mult[iy][ix][1];
+            lbb += m_screen->mult[iy][ix][2] * l;
+            lbw += m_screen->mult[iy][ix][2];
+          }
+        rr += lrr;
+        rw += lrw;
+        gg += lgg;
+        gw += lgw;
+        bb += lbb;
+        bw += lbw;
       }
+  }
   if (rw)
-    *r = rr / rw;
+    *r = (luminosity_t)(rr / rw);
   else
     *r = 0;
   if (gw)
-    *g = gg / gw;
+    *g = (luminosity_t)(gg / gw);
   else
     *g = 0;
   if (bw)
-    *b = bb / bw;
+    *b = (luminosity_t)(bb / bw);
   else
     *b = 0;
 }
@@ -0,0 +1,141 @@
+/* Cache of linear tile data used to re-run only the output stage.
+   Copyright (C) 2014-2026 Jan Hubicka
+   This file is part of Color-Screen.  */
+
+#ifndef RENDER_TILE_CACHE_H
+#define RENDER_TILE_CACHE_H
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include "include/render-parameters.h"
+#include "include/render-type-parameters.h"
+#include "include/scr-to-img-parameters.h"
+
+namespace colorscreen
+{
+class image_data;
+
+/* Tile rendered by render_to_scr::render_tile in linear process colors,
+   i.e. values passed to out_color_adjustments::final_color.  If only
+   output stage parameters change (white balance, dye balance, saturation,
+   output tone curve, output gamma...), the tile can be finished from DATA
+   without resampling the scan.  */
+struct linear_tile
+{
+  /* Identification of the image and rendering which produced DATA.  */
+  uint64_t img_id = 0;
+  scr_to_img_parameters param;
+  render_type_parameters rtparam;
+  /* Rendering parameters after render_parameters::adjust_for.  */
+  render_parameters rparam;
+  int width = 0, height = 0;
+  double xoffset = 0, yoffset = 0, step = 0;
+
+  /* Arguments used by the renderer to precompute its output stage.  */
+  bool normalized_patches = false;
+  rgbdata patch_proportions = { (luminosity_t)(1.0 / 3), (luminosity_t)(1.0 / 3), (luminosity_t)(1.0 / 3) };
+
+  /* WIDTH * HEIGHT linear colors allocated by malloc.  */
+  rgbdata *data = nullptr;
+  /* Nonzero for rows of DATA which were rendered before the rendering was
+     cancelled.  Empty if all rows are valid.  */
+  std::vector<uint8_t> done_rows;
+  /* Partially rendered tile this tile is rendered from.  Its completed
+     rows are reused rather than sampled again.  */
+  std::shared_ptr<linear_tile> resume;
+
+  linear_tile () = default;
+  linear_tile (const linear_tile &) = delete;
+  linear_tile &operator= (const linear_tile &) = delete;
+  ~linear_tile ()
+  {
+    free (data);
+  }
+
+  /* Return true if row Y of DATA is valid.  */
+  bool
+  row_done_p (int y) const
+  {
+    return done_rows.empty () || done_rows[y];
+  }
+
+  /* Return true if all rows of DATA are valid.  */
+  bool
+  complete_p () const
+  {
+    return data
+           && std::find (done_rows.begin (), done_rows.end (), 0)
+                  == done_rows.end ();
+  }
+
+  /* Return true if THIS and OTHER describe the same area of the same image
+     rendered with same sampling and parameters up to the output stage.  */
+  bool
+  reusable_for_p (const linear_tile &other) const
+  {
+    return img_id == other.img_id && width == other.width
+	   && height == other.height && xoffset == other.xoffset
+	   && yoffset == other.yoffset && step == other.step
+	   && rtparam.type == other.rtparam.type
+	   && rtparam.color == other.rtparam.color
+	   && rtparam.antialias == other.rtparam.antialias
+	   && rtparam.coordinate_error == other.rtparam.coordinate_error
+	   && param == other.param
+	   && rparam.invalidated_stage (other.rparam)
+	      != render_parameters::render_stage_all;
+  }
+};
+
+/* Renderer kept alive between tiles by tile_renderer_state.  */
+struct tile_renderer_entry
+{
+  virtual ~tile_renderer_entry () {}
+};
+
+/* Renderer RENDER of type T for image IMG_ID with parameters PARAM (of
+   type P), RPARAM and RTPARAM with data precomputed for image AREA.  RENDER
+   refers to PARAM, so entries are never copied.  */
+template <typename T, typename P>
+struct tile_renderer_entry_of : public tile_renderer_entry
+{
+  uint64_t img_id = 0;
+  P param;
+  render_parameters rparam;
+  render_type_parameters rtparam;
+  int_image_area area;
+  std::unique_ptr<T> render;
+};
+
+/* Renderers with precomputed data kept between tiles rendered with the same
+   parameters, so consecutive tiles do not need to set up the renderer and
+   look up precomputed data in global caches again.  Not thread safe; every
+   thread needs its own state.  */
+struct tile_renderer_state
+{
+  /* Number of renderers remembered.  */
+  static const size_t max_entries = 4;
+  /* Most recently used first.  */
+  std::vector<std::shared_ptr<tile_renderer_entry>> entries;
+  /* Number of renderers reused and created.  */
+  uint64_t reused = 0, created = 0;
+};
+
+/* Return true if tile of type RTPARAM of IMG with WIDTH x HEIGHT pixels
+   is worth remembering in linear tile cache.  */
+bool linear_tile_cacheable_p (const render_type_parameters &rtparam,
+			      const image_data &img, int width, int height);
+
+/* Return cached tile usable to render KEY or NULL.  */
+std::shared_ptr<linear_tile> linear_tile_cache_lookup (const linear_tile &key);
+
+/* Remember TILE for future lookups.  */
+void linear_tile_cache_store (std::shared_ptr<linear_tile> tile);
+
+/* Test hooks.  Return number of hits and misses since last prune.  */
+void linear_tile_cache_stats_for_test (uint64_t *hits, uint64_t *misses);
+/* Drop all cached tiles and reset statistics.  */
+void linear_tile_cache_prune_for_test ();
+}
+#endif
@@ -3,11 +3,14 @@
    This file is part of Color-Screen.  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include <sys/time.h>
 #include <mutex>
 #include "include/colorscreen.h"
 #include "include/stitch.h"
+#include "render-tile-cache.h"
+#include "coordinate-grid.h"
 
 namespace colorscreen
 {
@@ -30,13 +33,108 @@ putpixel (unsigned char *pixels, int pixelbytes, int rowstride, int x, int y,
     *(pixels + y * rowstride + x * pixelbytes + 3) = 255;
 }
 
+/* Remember output stage setup of RENDER in LINEAR and take ownership of
+   linear tile DATA.  */
+template<typename T> static inline void
+record_linear_tile (linear_tile *linear, T &render, rgbdata *data)
+{
+  linear->normalized_patches = render.out_color.normalized_patches_p ();
+  linear->patch_proportions = render.out_color.patch_proportions ();
+  linear->data = data;
+}
+
+/* Return renderer of type T for PARAM, IMG, RPARAM and RTPARAM with data
+   precomputed for image AREA, or NULL on failure.  If STATE is non-NULL,
+   reuse the renderer of a previous tile with the same parameters and
+   remember the new one for future tiles.  PROGRESS is used for progress
+   reporting.  */
+template<typename T, typename P>
+std::shared_ptr<T>
+prepare_tile_renderer (render_type_parameters &rtparam, P &param,
+		       image_data &img, render_parameters &rparam,
+		       int_image_area area, progress_info *progress,
+		       tile_renderer_state *state)
+{
+  typedef tile_renderer_entry_of<T, P> entry_t;
+  std::shared_ptr<entry_t> entry;
+  if (state && img.id)
+    {
+      for (size_t i = 0; i < state->entries.size (); i++)
+	{
+	  std::shared_ptr<entry_t> e
+	    = std::dynamic_pointer_cast<entry_t> (state->entries[i]);
+	  /* Compare render parameters by invalidated_stage rather than
+	     operator==, which ignores parameters used only by the output
+	     stage (such as the output profile).  Those are baked into the
+	     renderer as well.  */
+	  if (!e || e->img_id != img.id || !(e->param == param)
+	      || rparam.invalidated_stage (e->rparam)
+		 != render_parameters::render_stage_none
+	      || e->rtparam != rtparam)
+	    continue;
+	  state->entries.erase (state->entries.begin () + i);
+	  if (e->area.contains_p (area))
+	    {
+	      state->entries.insert (state->entries.begin (), e);
+	      state->reused++;
+	      return std::shared_ptr<T> (e, e->render.get ());
+	    }
+	  /* Precompute the union of both areas, so panning back does not
+	     need to precompute again.  Also grow it geometrically within the
+	     image, so a sequence of neighbouring tiles needs only a few
+	     precomputations.  */
+	  area.extend (e->area.top_left ());
+	  area.extend (e->area.bottom_right ());
+	  int_image_area grown
+	    = int_image_area (area.x - area.width, area.y - area.height,
+			      area.width * 3, area.height * 3)
+		.intersect ({ 0, 0, img.width, img.height });
+	  if (!grown.empty_p ())
+	    {
+	      area.extend (grown.top_left ());
+	      area.extend (grown.bottom_right ());
+	    }
+	  break;
+	}
+      entry = std::make_shared<entry_t> ();
+      entry->img_id = img.id;
+      entry->param = param;
+      entry->rparam = rparam;
+      entry->rtparam = rtparam;
+      entry->area = area;
+    }
+  std::unique_ptr<T> render
+    = std::make_unique<T> (entry ? entry->param : param, img,
+			   entry ? entry->rparam : rparam, 255);
+  render->set_render_type (rtparam);
+  if (progress)
+    progress->set_task ("precomputing", 1);
+  {
+    sub_task task (progress);
+    if (!render->precompute_img_range (area, progress))
+      return NULL;
+  }
+  if (!entry)
+    return std::shared_ptr<T> (std::move (render));
+  entry->render = std::move (render);
+  state->created++;
+  state->entries.insert (state->entries.begin (), entry);
+  if (state->entries.size () > tile_renderer_state::max_entries)
+    state->entries.pop_back ();
+  return std::shared_ptr<T> (entry, entry->render.get ());
+}
+
 /* Template for normal rendering, which calls render_pixel on every pixel.
    Main motivation to do rendering cores as templates is to get things nicely inlined.
    RTPARAM specifies rendering type, PARAM is the screen-to-image mapping parameters,
    IMG is the image data, RPARAM is the rendering parameters, PIXELS is the output buffer,
    PIXELBYTES is the bytes per pixel, ROWSTRIDE is the row stride, WIDTH and HEIGHT are
    tile dimensions, XOFFSET and YOFFSET are coordinates in the output image,
-   STEP is the sampling step, and PROGRESS is used for progress reporting.  */
+   STEP is the sampling step, and PROGRESS is used for progress reporting.
+   If LINEAR is non-NULL, record linear colors of the tile to it.
+   If COMPLETED_ROWS is non-NULL, set its elements to 1 for rows of PIXELS
+   finished before cancellation.  STATE, if non-NULL, keeps the renderer
+   for later tiles.  */
 template<typename T, typename P, typename RP>
 bool render_img_normal(render_type_parameters rtparam,
 		       P &param, image_data &img,
@@ -45,35 +143,60 @@ bool render_img_normal(render_type_parameters rtparam,
 		       int width, int height,
 		       double xoffset, double yoffset,
 		       double step,
-		       progress_info *progress)
+		       progress_info *progress,
+		       linear_tile *linear = nullptr,
+		       uint8_t *completed_rows = nullptr,
+		       tile_renderer_state *state = nullptr)
 {
-  T render (param, img, rparam, 255);
-  render.set_render_type (rtparam);
-  if (progress)
-    progress->set_task ("precomputing", 1);
-  {
-    sub_task task (progress);
-    if (!render.precompute_img_range ({{(int)(xoffset * step), (int)(yoffset * step)},
-				      {(int)((width + xoffset) * step),
-				       (int)((height + yoffset) * step)}}, progress))
-      return false;
-  }
+  std::shared_ptr<T> renderer
+    = prepare_tile_renderer<T> (rtparam, param, img, rparam,
+				{{(int)(xoffset * step), (int)(yoffset * step)},
+				 {(int)((width + xoffset) * step),
+				  (int)((height + yoffset) * step)}},
+				progress, state);
+  if (!renderer)
+    return false;
+  T &render = *renderer;
+  rgbdata *data = NULL;
+  uint8_t *done_rows = NULL;
+  /* Rows completed by previous cancelled rendering.  */
+  const linear_tile *resume = NULL;
+  if (linear)
+    {
+      data = (rgbdata *)malloc (sizeof (rgbdata) * width * height);
+      linear->done_rows.assign (height, 0);
+      done_rows = linear->done_rows.data ();
+      resume = linear->resume.get ();
+    }
   if (progress)
     progress->set_task ("rendering", height);
-#pragma omp parallel for default(none) shared(progress,pixels,render,pixelbytes,rowstride,height, width,step,yoffset,xoffset) if (width * (size_t)height > render.openmp_size ())
+#pragma omp parallel for default(none) shared(progress,pixels,render,pixelbytes,rowstride,height, width,step,yoffset,xoffset,data,done_rows,resume,completed_rows) if (width * (size_t)height > render.openmp_size ())
   for (int y = 0; y < height; y++)
     {
       coord_t py = (y + yoffset) * step;
       if (!progress || !progress->cancel_requested ())
-	for (int x = 0; x < width; x++)
-	  {
-	    rgbdata c = render.sample_pixel_img ({(coord_t)((x + xoffset) * step), py});
-	    int_rgbdata out_c = render.out_color.final_color (c);
-	    putpixel (pixels, pixelbytes, rowstride, x, y, out_c.red, out_c.green, out_c.blue);
-	  }
+	{
+	  const rgbdata *reuse = resume && resume->row_done_p (y)
+				 ? resume->data + width * y : NULL;
+	  for (int x = 0; x < width; x++)
+	    {
+	      rgbdata c = reuse ? reuse[x]
+			  : render.sample_pixel_img ({(coord_t)((x + xoffset) * step), py});
+	      if (data)
+		data[x + width * y] = c;
+	      int_rgbdata out_c = render.out_color.final_color (c);
+	      putpixel (pixels, pixelbytes, rowstride, x, y, out_c.red, out_c.green, out_c.blue);
+	    }
+	  if (done_rows)
+	    done_rows[y] = 1;
+	  if (completed_rows)
+	    completed_rows[y] = 1;
+	}
        if (progress)
 	 progress->inc_progress ();
     }
+  if (data)
+    record_linear_tile (linear, render, data);
   return true;
 }
 
@@ -82,7 +205,11 @@ bool render_img_normal(render_type_parameters rtparam,
    IMG is the image data, RPARAM is the rendering parameters, PIXELS is the output buffer,
    PIXELBYTES is the bytes per pixel, ROWSTRIDE is the row stride, WIDTH and HEIGHT are
    tile dimensions, XOFFSET and YOFFSET are coordinates in the output image,
-   STEP is the sampling step, and PROGRESS is used for progress reporting.  */
+   STEP is the sampling step, and PROGRESS is used for progress reporting.
+   If LINEAR is non-NULL, record linear colors of the tile to it.
+   If COMPLETED_ROWS is non-NULL, set its elements to 1 for rows of PIXELS
+   finished before cancellation.  STATE, if non-NULL, keeps the renderer
+   for later tiles.  */
 template<typename T, typename P,typename RP>
 bool render_img_downscale(render_type_parameters rtparam,
 			  P &param, image_data &img,
@@ -91,19 +218,20 @@ bool render_img_downscale(render_type_parameters rtparam,
 			  int width, int height,
 			  double xoffset, double yoffset,
 			  double step,
-			  progress_info *progress)
+			  progress_info *progress,
+			  linear_tile *linear = nullptr,
+			  uint8_t *completed_rows = nullptr,
+			  tile_renderer_state *state = nullptr)
 {
-  T render (param, img, rparam, 255);
-  render.set_render_type (rtparam);
-  if (progress)
-    progress->set_task ("precomputing", 1);
-  {
-    sub_task task (progress);
-    if (!render.precompute_img_range ({{(int)(xoffset * step), (int)(yoffset * step)},
-				      {(int)((width + xoffset) * step),
-				       (int)((height + yoffset) * step)}}, progress))
-      return false;
-  }
+  std::shared_ptr<T> renderer
+    = prepare_tile_renderer<T> (rtparam, param, img, rparam,
+				{{(int)(xoffset * step), (int)(yoffset * step)},
+				 {(int)((width + xoffset) * step),
+				  (int)((height + yoffset) * step)}},
+				progress, state);
+  if (!renderer)
+    return false;
+  T &render = *renderer;
   rgbdata *data = (rgbdata *)malloc (sizeof (rgbdata) * width * height);
   if (!data)
     return false;
@@ -114,19 +242,26 @@ bool render_img_downscale(render_type_parameters rtparam,
     }
   if (progress)
     progress->set_task ("rendering", height);
-#pragma omp parallel for default(none) shared(progress,pixels,render,pixelbytes,rowstride,height, width,step,yoffset,xoffset,data) if (width * (size_t)height > render.openmp_size ())
+#pragma omp parallel for default(none) shared(progress,pixels,render,pixelbytes,rowstride,height, width,step,yoffset,xoffset,data,completed_rows) if (width * (size_t)height > render.openmp_size ())
   for (int y = 0; y < height; y++)
     {
       if (!progress || !progress->cancel_requested ())
-	for (int x = 0; x < width; x++)
-	  {
-	    int_rgbdata out_c = render.out_color.final_color (data[x + width * y]);
-	    putpixel (pixels, pixelbytes, rowstride, x, y, out_c.red, out_c.green, out_c.blue);
-	  }
+	{
+	  for (int x = 0; x < width; x++)
+	    {
+	      int_rgbdata out_c = render.out_color.final_color (data[x + width * y]);
+	      putpixel (pixels, pixelbytes, rowstride, x, y, out_c.red, out_c.green, out_c.blue);
+	    }
+	  if (completed_rows)
+	    completed_rows[y] = 1;
+	}
        if (progress)
 	 progress->inc_progress ();
     }
-  free (data);
+  if (linear)
+    record_linear_tile (linear, render, data);
+  else
+    free (data);
   return true;
 }
 
@@ -135,7 +270,11 @@ bool render_img_downscale(render_type_parameters rtparam,
    IMG is the image data, RPARAM is the rendering parameters, PIXELS is the output buffer,
    PIXELBYTES is the bytes per pixel, ROWSTRIDE is the row stride, WIDTH and HEIGHT are
    tile dimensions, XOFFSET and YOFFSET are coordinates in the output image,
-   STEP is the sampling step, and PROGRESS is used for progress reporting.  */
+   STEP is the sampling step, and PROGRESS is used for progress reporting.
+   If LINEAR is non-NULL, record linear colors of the tile to it.
+   If COMPLETED_ROWS is non-NULL, set its elements to 1 for rows of PIXELS
+   finished before cancellation.  STATE, if non-NULL, keeps the renderer
+   for later tiles.  */
 template<typename T>
 bool render_img_gray_downscale(render_type_parameters rtparam,
 			       scr_to_img_parameters &param, image_data &img,
@@ -144,19 +283,20 @@ bool render_img_gray_downscale(render_type_parameters rtparam,
 			       int width, int height,
 			       double xoffset, double yoffset,
 			       double step,
-			       progress_info *progress)
+			       progress_info *progress,
+			       linear_tile *linear = nullptr,
+			       uint8_t *completed_rows = nullptr,
+			       tile_renderer_state *state = nullptr)
 {
-  T render (param, img, rparam, 255);
-  render.set_render_type (rtparam);
-  if (progress)
-    progress->set_task ("precomputing", 1);
-  {
-    sub_task task (progress);
-    if (!render.precompute_img_range ({{(int)(xoffset * step), (int)(yoffset * step)},
-				      {(int)((width + xoffset) * step),
-				       (int)((height + yoffset) * step)}}, progress))
-      return false;
-  }
+  std::shared_ptr<T> renderer
+    = prepare_tile_renderer<T> (rtparam, param, img, rparam,
+				{{(int)(xoffset * step), (int)(yoffset * step)},
+				 {(int)((width + xoffset) * step),
+				  (int)((height + yoffset) * step)}},
+				progress, state);
+  if (!renderer)
+    return false;
+  T &render = *renderer;
   luminosity_t *data = (luminosity_t *)malloc (sizeof (luminosity_t) * width * height);
   if (!data)
     return false;
@@ -165,21 +305,40 @@ bool render_img_gray_downscale(render_type_parameters rtparam,
       free (data);
       return false;
     }
+  rgbdata *rgb = NULL;
+  uint8_t *done_rows = NULL;
+  if (linear)
+    {
+      rgb = (rgbdata *)malloc (sizeof (rgbdata) * width * height);
+      linear->done_rows.assign (height, 0);
+      done_rows = linear->done_rows.data ();
+    }
   if (progress)
     progress->set_task ("rendering", height);
-#pragma omp parallel for default(none) shared(progress,pixels,render,pixelbytes,rowstride,height, width,step,yoffset,xoffset,data) if (width * (size_t)height > render.openmp_size ())
+#pragma omp parallel for default(none) shared(progress,pixels,render,pixelbytes,rowstride,height, width,step,yoffset,xoffset,data,rgb,done_rows,completed_rows) if (width * (size_t)height > render.openmp_size ())
   for (int y = 0; y < height; y++)
     {
       if (!progress || !progress->cancel_requested ())
-	for (int x = 0; x < width; x++)
-	  {
-	    int_rgbdata out_c = render.out_color.final_color ({data[x + width * y], data[x + width * y], data[x + width * y]});
-	    putpixel (pixels, pixelbytes, rowstride, x, y, out_c.red, out_c.green, out_c.blue);
-	  }
+	{
+	  for (int x = 0; x < width; x++)
+	    {
+	      rgbdata c = {data[x + width * y], data[x + width * y], data[x + width * y]};
+	      if (rgb)
+		rgb[x + width * y] = c;
+	      int_rgbdata out_c = render.out_color.final_color (c);
+	      putpixel (pixels, pixelbytes, rowstride, x, y, out_c.red, out_c.green, out_c.blue);
+	    }
+	  if (done_rows)
+	    done_rows[y] = 1;
+	  if (completed_rows)
+	    completed_rows[y] = 1;
+	}
        if (progress)
 	 progress->inc_progress ();
     }
   free (data);
+  if (rgb)
+    record_linear_tile (linear, render, rgb);
   return true;
 }
 
@@ -221,7 +380,7 @@ init_render_img (RP &rtparam, render_parameters &my_rparam, image_data &img, scr
    This is used for render engines which do their own translation of scr to img coordinates
    (inherited from render_scr).  RENDER is the rendering engine.  */
 template<typename T> inline rgbdata
-render_loop_scr (T &render, scr_to_img &, int antialias, coord_t x, coord_t y, coord_t step)
+render_loop_scr (T &render, scr_to_img &, const coordinate_grid &, int antialias, coord_t x, coord_t y, coord_t step)
 {
   rgbdata d;
   if (antialias == 1)
@@ -242,15 +401,17 @@ render_loop_scr (T &render, scr_to_img &, int antialias, coord_t x, coord_t y, c
 }
 
 /* Same as render_loop_scr but for render engines which handle only image coordinates.
-   RENDER is the rendering engine, MAP is the screen-to-image map, ANTIALIAS is the
+   RENDER is the rendering engine, MAP is the screen-to-image map, GRID is its
+   approximation used for points it covers, ANTIALIAS is the
    anti-aliasing factor, X and Y are screen coordinates, and STEP is the sampling step.  */
 template<typename T> inline rgbdata
-render_loop_img (T &render, scr_to_img &map, int antialias, coord_t x, coord_t y, coord_t step)
+render_loop_img (T &render, scr_to_img &map, const coordinate_grid &grid, int antialias, coord_t x, coord_t y, coord_t step)
 {
   rgbdata d;
   if (antialias == 1)
     {
-      point_t p = map.to_img ({x, y});
+      point_t s = {x, y};
+      point_t p = grid.in_range_p (s) ? grid.apply (s) : map.to_img (s);
       d = render.sample_pixel_img (p);
     }
   else
@@ -260,7 +421,8 @@ render_loop_img (T &render, scr_to_img &map, int antialias, coord_t x, coord_t y
       for (int ax = 0; ax < antialias; ax++)
 	for (int ay = 0; ay < antialias; ay++)
 	  {
-	    point_t p = map.to_img ({x + ax * substep, y + ay * substep});
+	    point_t s = {x + ax * substep, y + ay * substep};
+	    point_t p = grid.in_range_p (s) ? grid.apply (s) : map.to_img (s);
 	    d += render.sample_pixel_img (p);
 	  }
       luminosity_t ainv = 1 / (luminosity_t)(antialias * antialias);
@@ -281,7 +443,7 @@ render_loop_img (T &render, scr_to_img &map, int antialias, coord_t x, coord_t y
    for progress reporting.  */
 template<typename T, typename P,typename RP,
 	 /* Function to render pixel at a given coordinates and with a given anti-aliasing.  */
-       	 rgbdata (render_loop) (T &, scr_to_img &, int, coord_t, coord_t, coord_t),
+       	 rgbdata (render_loop) (T &, scr_to_img &, const coordinate_grid &, int, coord_t, coord_t, coord_t),
 	 /* Function to initialize renderer on demand.  */
        	 T *(init_render) (RP &, render_parameters &, image_data &, scr_to_img_parameters &, P &, progress_info *progress)>
 void render_stitched(RP &rtparam, P &outer_param,
@@ -371,9 +533,39 @@ void render_stitched(RP &rtparam, P &outer_param,
 	    }
 	  }
   }
+
+  /* Approximations of mappings of the individual images to image
+     coordinates over the screen area of the tile.  Renderers working in
+     screen coordinates approximate the mapping themselves.  The mapping
+     from final to screen coordinates is affine and is not approximated.  */
+  std::vector<coordinate_grid> grids (stitch.params.width * stitch.params.height);
+  if (render_loop == render_loop_img<T> && rtparam.coordinate_error > 0
+      && (!progress || !progress->cancel_requested ()))
+    {
+      point_t c[4] = { stitch.common_scr_to_img.final_to_scr ({xoffset * step + xmin, yoffset * step + ymin}),
+		       stitch.common_scr_to_img.final_to_scr ({(width + xoffset) * step + xmin, yoffset * step + ymin}),
+		       stitch.common_scr_to_img.final_to_scr ({xoffset * step + xmin, (height + yoffset) * step + ymin}),
+		       stitch.common_scr_to_img.final_to_scr ({(width + xoffset) * step + xmin, (height + yoffset) * step + ymin}) };
+      point_t min = c[0], max = c[0];
+      for (int i = 1; i < 4; i++)
+	{
+	  min = { std::min (min.x, c[i].x), std::min (min.y, c[i].y) };
+	  max = { std::max (max.x, c[i].x), std::max (max.y, c[i].y) };
+	}
+      for (int iy = 0; iy < stitch.params.height; iy++)
+	for (int ix = 0; ix < stitch.params.width; ix++)
+	  if (renders[iy * stitch.params.width + ix])
+	    {
+	      scr_to_img &map = stitch.images[iy][ix].scr_to_img_map;
+	      point_t pos = stitch.images[iy][ix].pos;
+	      grids[iy * stitch.params.width + ix].init ([&map] (point_t s) { return map.to_img (s); },
+							  { min.x - pos.x, min.y - pos.y, max.x - min.x, max.y - min.y },
+							  rtparam.coordinate_error);
+	    }
+    }
   if (progress)
     progress->set_task ("rendering", height);
-#pragma omp parallel for default(none) shared(img,rtparam,rparam,progress,pixels,renders,pixelbytes,rowstride,height, width,step,yoffset,xoffset,xmin,ymin,stitch,lock,antialias,outer_param) if (width * height * antialias * antialias > openmp_size)
+#pragma omp parallel for default(none) shared(img,rtparam,rparam,progress,pixels,renders,pixelbytes,rowstride,height, width,step,yoffset,xoffset,xmin,ymin,stitch,lock,antialias,outer_param,grids) if (width * height * antialias * antialias > openmp_size)
   for (int y = 0; y < height; y++)
     {
       /* Try to use same renderer as for last tile to avoid accessing atomic pointer.  */
@@ -433,7 +625,7 @@ void render_stitched(RP &rtparam, P &outer_param,
 		lastx = ix;
 		lasty = iy;
 	      }
-	  rgbdata d = render_loop (*lastrender, stitch.images[lasty][lastx].scr_to_img_map, antialias, scr.x - stitch.images[lasty][lastx].pos.x, scr.y - stitch.images[lasty][lastx].pos.y, step);
+	  rgbdata d = render_loop (*lastrender, stitch.images[lasty][lastx].scr_to_img_map, grids[lasty * stitch.params.width + lastx], antialias, scr.x - stitch.images[lasty][lastx].pos.x, scr.y - stitch.images[lasty][lastx].pos.y, step);
 	  int_rgbdata out_c = lastrender->out_color.final_color (d);
 	  putpixel (pixels, pixelbytes, rowstride, x, y, out_c.red, out_c.green, out_c.blue);
 	}
@@ -455,7 +647,10 @@ void render_stitched(RP &rtparam, P &outer_param,
    IMG is the image data, RPARAM is the rendering parameters, PIXELS is the output buffer,
    PIXELBYTES is the bytes per pixel, ROWSTRIDE is the row stride, WIDTH and HEIGHT are
    tile dimensions, XOFFSET and YOFFSET are coordinates in the output image,
-   STEP is the sampling step, and PROGRESS is used for progress reporting.  */
+   STEP is the sampling step, and PROGRESS is used for progress reporting.
+   LINEAR, if non-NULL, is passed to render_img_* to record linear colors.
+   COMPLETED_ROWS, if non-NULL, is set to 1 for rows finished before
+   cancellation.  STATE, if non-NULL, keeps renderers for later tiles.  */
 template<typename T>
 bool do_render_tile(render_type_parameters &rtparam,
 		    scr_to_img_parameters &param,
@@ -465,20 +660,26 @@ bool do_render_tile(render_type_parameters &rtparam,
 		    int width, int height,
 		    double xoffset, double yoffset,
 		    double step,
-		    progress_info *progress)
+		    progress_info *progress,
+		    linear_tile *linear = nullptr,
+		    uint8_t *completed_rows = nullptr,
+		    tile_renderer_state *state = nullptr)
 {
   if (img.stitch)
     {
       render_stitched<T,scr_to_img_parameters,render_type_parameters,render_loop_scr,init_render_scr<T,scr_to_img_parameters,render_type_parameters>> (rtparam, param, img, rparam, pixels, pixelbytes, rowstride, width, height, xoffset, yoffset, step, rtparam.antialias, progress);
+      /* Stitched rendering does not track individual rows.  */
+      if (completed_rows && (!progress || !progress->cancel_requested ()))
+	memset (completed_rows, 1, height);
       return true;
     }
 
   if (progress)
     progress->set_task ("rendering", height);
   if (step > 1 && rtparam.antialias)
-    return render_img_downscale<T> (rtparam, param, img, rparam, pixels, pixelbytes, rowstride, width, height, xoffset, yoffset, step, progress);
+    return render_img_downscale<T> (rtparam, param, img, rparam, pixels, pixelbytes, rowstride, width, height, xoffset, yoffset, step, progress, linear, completed_rows, state);
   else
-    return render_img_normal<T> (rtparam, param, img, rparam, pixels, pixelbytes, rowstride, width, height, xoffset, yoffset, step, progress);
+    return render_img_normal<T> (rtparam, param, img, rparam, pixels, pixelbytes, rowstride, width, height, xoffset, yoffset, step, progress, linear, completed_rows, state);
 }
 
 /* Main entry to rendering if graydata needs to be handled specially.
@@ -486,7 +687,10 @@ bool do_render_tile(render_type_parameters &rtparam,
    IMG is the image data, RPARAM is the rendering parameters, PIXELS is the output buffer,
    PIXELBYTES is the bytes per pixel, ROWSTRIDE is the row stride, WIDTH and HEIGHT are
    tile dimensions, XOFFSET and YOFFSET are coordinates in the output image,
-   STEP is the sampling step, and PROGRESS is used for progress reporting.  */
+   STEP is the sampling step, and PROGRESS is used for progress reporting.
+   LINEAR, if non-NULL, is passed to render_img_* to record linear colors.
+   COMPLETED_ROWS, if non-NULL, is set to 1 for rows finished before
+   cancellation.  STATE, if non-NULL, keeps renderers for later tiles.  */
 template<typename T>
 bool do_render_tile_with_gray(render_type_parameters &rtparam,
 			      scr_to_img_parameters &param,
@@ -496,11 +700,17 @@ bool do_render_tile_with_gray(render_type_parameters &rtparam,
 			      int width, int height,
 			      double xoffset, double yoffset,
 			      double step,
-			      progress_info *progress)
+			      progress_info *progress,
+			      linear_tile *linear = nullptr,
+			      uint8_t *completed_rows = nullptr,
+			      tile_renderer_state *state = nullptr)
 {
   if (img.stitch)
     {
       render_stitched<T,scr_to_img_parameters,render_type_parameters,render_loop_scr,init_render_scr<T,scr_to_img_parameters,render_type_parameters>> (rtparam, param, img, rparam, pixels, pixelbytes, rowstride, width, height, xoffset, yoffset, step, rtparam.antialias, progress);
+      /* Stitched rendering does not track individual rows.  */
+      if (completed_rows && (!progress || !progress->cancel_requested ()))
+	memset (completed_rows, 1, height);
       return true;
     }
 
@@ -509,12 +719,12 @@ bool do_render_tile_with_gray(render_type_parameters &rtparam,
   if (step > 1 && rtparam.antialias)
     {
       if (!rtparam.color)
-        return render_img_gray_downscale<T> (rtparam, param, img, rparam, pixels, pixelbytes, rowstride, width, height, xoffset, yoffset, step, progress);
+        return render_img_gray_downscale<T> (rtparam, param, img, rparam, pixels, pixelbytes, rowstride, width, height, xoffset, yoffset, step, progress, linear, completed_rows, state);
       else
-        return render_img_downscale<T> (rtparam, param, img, rparam, pixels, pixelbytes, rowstride, width, height, xoffset, yoffset, step, progress);
+        return render_img_downscale<T> (rtparam, param, img, rparam, pixels, pixelbytes, rowstride, width, height, xoffset, yoffset, step, progress, linear, completed_rows, state);
     }
   else
-    return render_img_normal<T> (rtparam, param, img, rparam, pixels, pixelbytes, rowstride, width, height, xoffset, yoffset, step, progress);
+    return render_img_normal<T> (rtparam, param, img, rparam, pixels, pixelbytes, rowstride, width, height, xoffset, yoffset, step, progress, linear, completed_rows, state);
 }
 
 /* Main entry to rendering for image detection.
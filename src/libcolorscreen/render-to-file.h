@@ -3,7 +3,9 @@
    This file is part of Color-Screen.  */
 
 #include <atomic>
+#include <vector>
 #include "include/tiff-writer.h"
+#include "coordinate-grid.h"
 
 namespace colorscreen
 {
@@ -17,13 +19,15 @@ namespace
      (scaling, rotation, skewing) for the output image.  */
 
 /** Sample pixel from rendering engine RENDER at FINAL coordinates X, Y
-    translated to image coordinates via MAP.
+    translated to image coordinates via MAP or, if it covers the point,
+    via its approximation GRID.
     FINAL_XSHIFT and FINAL_YSHIFT are offsets in final coordinates.  */
 template<typename T>
 inline rgbdata
-sample_data_final_by_img (T &render, scr_to_img &map, coord_t x, coord_t y, int final_xshift, int final_yshift)
+sample_data_final_by_img (T &render, scr_to_img &map, const coordinate_grid &grid, coord_t x, coord_t y, int final_xshift, int final_yshift)
 {
-  point_t p = map.final_to_img ({x - final_xshift, y - final_yshift});
+  point_t f = {x - final_xshift, y - final_yshift};
+  point_t p = grid.in_range_p (f) ? grid.apply (f) : map.final_to_img (f);
   return render.sample_pixel_img (p);
 }
 
@@ -32,7 +36,7 @@ sample_data_final_by_img (T &render, scr_to_img &map, coord_t x, coord_t y, int
     FINAL_XSHIFT and FINAL_YSHIFT are offsets in final coordinates.  */
 template<typename T>
 inline rgbdata
-sample_data_final_by_scr (T &render, scr_to_img &map, coord_t x, coord_t y, int final_xshift, int final_yshift)
+sample_data_final_by_scr (T &render, scr_to_img &map, const coordinate_grid &, coord_t x, coord_t y, int final_xshift, int final_yshift)
 {
   point_t p = map.final_to_scr ({x - final_xshift, y - final_yshift});
   return render.sample_pixel_scr (p);
@@ -42,7 +46,7 @@ sample_data_final_by_scr (T &render, scr_to_img &map, coord_t x, coord_t y, int
     directly in final coordinates.  */
 template<typename T>
 inline rgbdata
-sample_data_final_by_final (T &render, scr_to_img &, coord_t x, coord_t y, int, int)
+sample_data_final_by_final (T &render, scr_to_img &, const coordinate_grid &, coord_t x, coord_t y, int, int)
 {
   return render.sample_pixel_final ({x, y});
 }
@@ -51,18 +55,20 @@ sample_data_final_by_final (T &render, scr_to_img &, coord_t x, coord_t y, int,
     directly in screen coordinates.  */
 template<typename T>
 inline rgbdata
-sample_data_scr_by_scr (T &render, scr_to_img &, coord_t x, coord_t y)
+sample_data_scr_by_scr (T &render, scr_to_img &, const coordinate_grid &, coord_t x, coord_t y)
 {
   return render.sample_pixel_scr ({x, y});
 }
 
 /** Sample pixel from rendering engine RENDER at SCREEN coordinates X, Y
-    translated to image coordinates via MAP.  */
+    translated to image coordinates via MAP or, if it covers the point,
+    via its approximation GRID.  */
 template<typename T>
 inline rgbdata
-sample_data_scr_by_img (T &render, scr_to_img &map, coord_t x, coord_t y)
+sample_data_scr_by_img (T &render, scr_to_img &map, const coordinate_grid &grid, coord_t x, coord_t y)
 {
-  point_t p = map.to_img ({x, y});
+  point_t s = {x, y};
+  point_t p = grid.in_range_p (s) ? grid.apply (s) : map.to_img (s);
   return render.sample_pixel_img (p);
 }
 
@@ -80,16 +86,97 @@ sample_data_scr_by_img (T &render, scr_to_img &map, coord_t x, coord_t y)
 /* Engine supports sampling in image coordinates; map from final/screen to image.  */
 #define supports_img sample_data_final_by_img, sample_data_scr_by_img
 
+/** Determine range of scan rows [*FIRST, *LAST) accessed while rendering
+    output rows Y0...Y1-1 with parameters P.  MAP, FINAL_XSHIFT and
+    FINAL_YSHIFT describe screen geometry.  Used to stream the scan when
+    only a band of rows is kept in memory.  */
+inline void
+scan_rows_for_output_rows (render_to_file_params &p, scr_to_img &map,
+			   image_data &img, int final_xshift, int final_yshift,
+			   int y0, int y1, int *first, int *last)
+{
+  /* Nearest neighbour sampling may round to neighbouring row.  */
+  const int margin = 2;
+  coord_t ymin, ymax;
+  if (p.geometry != render_to_file_params::screen_geometry)
+    {
+      ymin = y0 * p.ystep + p.start.y - final_yshift;
+      ymax = y1 * p.ystep + p.start.y - final_yshift;
+    }
+  else
+    {
+      /* Geometry may be non-linear; sample the strip densely.
+	 Antialiasing samples stay within the pixel, so sampling pixel
+	 corners (including row Y1 and column WIDTH) is enough.  */
+      const int xsamples = 64;
+      ymin = img.height;
+      ymax = 0;
+      for (int y = y0; y <= y1; y++)
+	for (int i = 0; i <= xsamples; i++)
+	  {
+	    coord_t x = p.width * (coord_t)i / xsamples;
+	    point_t pi = map.final_to_img ({x * p.xstep + p.start.x - final_xshift,
+					    y * p.ystep + p.start.y - final_yshift});
+	    ymin = std::min (ymin, pi.y);
+	    ymax = std::max (ymax, pi.y);
+	  }
+    }
+  *first = std::clamp ((int)my_floor (ymin) - margin, 0, img.height);
+  *last = std::clamp ((int)my_floor (ymax) + margin + 1, 0, img.height);
+}
+
+/** Initialize GRID approximating mapping to image coordinates used to
+    render output rows Y0...Y1-1 with parameters P, so it differs by at most
+    COORDINATE_ERROR image pixels.  MAP, FINAL_XSHIFT and FINAL_YSHIFT
+    describe screen geometry.  For tiles of stitched projects the grid maps
+    screen coordinates of the image (as sample_data_scr_by_img does),
+    otherwise it maps final coordinates (as sample_data_final_by_img does).
+    Final to screen coordinates are an affine transformation, so only the
+    mapping to image coordinates is approximated.  */
+inline void
+init_coordinate_grid (coordinate_grid &grid, render_to_file_params &p,
+		      scr_to_img &map, int final_xshift, int final_yshift,
+		      int y0, int y1, coord_t coordinate_error)
+{
+  grid.clear ();
+  if (!(coordinate_error > 0))
+    return;
+  coord_t fx0 = p.start.x, fx1 = p.start.x + p.width * p.xstep;
+  coord_t fy0 = y0 * p.ystep + p.start.y, fy1 = y1 * p.ystep + p.start.y;
+  if (p.tile)
+    {
+      point_t c[4] = { p.common_map->final_to_scr ({fx0, fy0}) - p.pos,
+		       p.common_map->final_to_scr ({fx1, fy0}) - p.pos,
+		       p.common_map->final_to_scr ({fx0, fy1}) - p.pos,
+		       p.common_map->final_to_scr ({fx1, fy1}) - p.pos };
+      point_t min = c[0], max = c[0];
+      for (int i = 1; i < 4; i++)
+	{
+	  min = { std::min (min.x, c[i].x), std::min (min.y, c[i].y) };
+	  max = { std::max (max.x, c[i].x), std::max (max.y, c[i].y) };
+	}
+      grid.init ([&map] (point_t s) { return map.to_img (s); },
+		 { min.x, min.y, max.x - min.x, max.y - min.y },
+		 coordinate_error);
+    }
+  else
+    grid.init ([&map] (point_t f) { return map.final_to_img (f); },
+	       { fx0 - final_xshift, fy0 - final_yshift, fx1 - fx0, fy1 - fy0 },
+	       coordinate_error);
+}
+
 /** Core function to render an image to a TIFF file.
     P - rendering parameters.
     PARAM - screen to image parameters.
     IMG - source image data.
     RENDER - rendering engine instance.
     BLACK - black level for DNG output.
-    PROGRESS - progress reporting object.  */
-template<typename T, rgbdata (sample_data_final)(T &render, scr_to_img &map, coord_t x, coord_t y, int, int), rgbdata (sample_data_scr)(T &render, scr_to_img &map, coord_t x, coord_t y)>
+    PROGRESS - progress reporting object.
+    COORDINATE_ERROR - if positive, mapping to image coordinates may be
+    approximated within this many image pixels.  */
+template<typename T, rgbdata (sample_data_final)(T &render, scr_to_img &map, const coordinate_grid &grid, coord_t x, coord_t y, int, int), rgbdata (sample_data_scr)(T &render, scr_to_img &map, const coordinate_grid &grid, coord_t x, coord_t y)>
 const char *
-produce_file (render_to_file_params &p, scr_to_img_parameters &param, image_data &img, T &render, int black, progress_info *progress)
+produce_file (render_to_file_params &p, scr_to_img_parameters &param, image_data &img, T &render, int black, progress_info *progress, coord_t coordinate_error = 0)
 {
   const char *error = nullptr;
   scr_to_img map;
@@ -161,15 +248,51 @@ produce_file (render_to_file_params &p, scr_to_img_parameters &param, image_data
       if (progress)
         progress->resume_stdout ();
     }
+  /* If scan is streamed, determine rows needed for every strip of output.
+     Rows needed by later strips must stay in memory; KEEP is the first
+     such row.  */
+  std::vector<int> strip_first, strip_last, strip_keep;
+  if (img.streaming_p ())
+    {
+      if (p.tile)
+	return "Streaming is not supported for stitched projects";
+      int n = out.get_n_rows ();
+      for (int y = 0; y < p.height; y += n)
+	{
+	  int first, last;
+	  scan_rows_for_output_rows (p, map, img, final_xshift, final_yshift,
+				     y, std::min (y + n, p.height),
+				     &first, &last);
+	  strip_first.push_back (first);
+	  strip_last.push_back (last);
+	}
+      strip_keep = strip_first;
+      for (int i = (int)strip_keep.size () - 2; i >= 0; i--)
+	strip_keep[i] = std::min (strip_keep[i], strip_keep[i + 1]);
+    }
+
   if (progress)
     progress->set_task ("rendering and saving", p.height * 2);
 
-  for (int y = 0; y < p.height;)
+  /* Engines sampling in image coordinates may use approximation of the
+     mapping; it is rebuilt for every strip.  */
+  bool use_grid = p.tile ? sample_data_scr == sample_data_scr_by_img<T>
+		  : p.geometry == render_to_file_params::screen_geometry
+		    && sample_data_final == sample_data_final_by_img<T>;
+  coordinate_grid grid;
+  for (int y = 0, strip = 0; y < p.height; strip++)
     {
+      if (img.streaming_p () && strip_first[strip] < strip_last[strip])
+	if (!img.load_rows (strip_keep[strip], strip_last[strip], &error,
+			    progress))
+	  return error;
+      if (use_grid)
+	init_coordinate_grid (grid, p, map, final_xshift, final_yshift, y,
+			      y + out.get_n_rows (), coordinate_error);
       if (p.antialias == 1)
 	{
 	  if (p.tile)
-#pragma omp parallel for default(none) shared(p, render, y, out, map, progress) collapse (2)
+#pragma omp parallel for default(none) shared(p, render, y, out, map, grid, progress) collapse (2)
 	    for (int row = 0; row < out.get_n_rows (); row++)
 	      for (int x = 0; x < p.width; x++)
 		{
@@ -184,7 +307,7 @@ produce_file (render_to_file_params &p, scr_to_img_parameters &param, image_data
 		  else
 		    {
 		      scr -= p.pos;
-		      rgbdata d = sample_data_scr (render, map, scr.x, scr.y);
+		      rgbdata d = sample_data_scr (render, map, grid, scr.x, scr.y);
 		      if (!p.hdr)
 			{
 			  int_rgbdata out_c = render.out_color.final_color_precise (d);
@@ -200,13 +323,13 @@ produce_file (render_to_file_params &p, scr_to_img_parameters &param, image_data
 		    progress->inc_progress ();
 		}
 	  else if (p.geometry == render_to_file_params::screen_geometry)
-#pragma omp parallel for default(none) shared(p, render, y, out, map, final_xshift, final_yshift, progress) collapse (2)
+#pragma omp parallel for default(none) shared(p, render, y, out, map, grid, final_xshift, final_yshift, progress) collapse (2)
 	    for (int row = 0; row < out.get_n_rows (); row++)
 	      for (int x = 0; x < p.width; x++)
 		{
 		  coord_t xx = x * p.xstep + p.start.x;
 		  coord_t yy = (y + row) * p.ystep + p.start.y;
-		  rgbdata d = sample_data_final (render, map, xx, yy, final_xshift, final_yshift);
+		  rgbdata d = sample_data_final (render, map, grid, xx, yy, final_xshift, final_yshift);
 		  if (!p.hdr)
 		    {
 		      int_rgbdata out_c = render.out_color.final_color_precise (d);
@@ -248,7 +371,7 @@ produce_file (render_to_file_params &p, scr_to_img_parameters &param, image_data
 	  coord_t asy = p.ystep / p.antialias;
 	  luminosity_t sc = 1.0 / (p.antialias * p.antialias);
 	  if (p.tile)
-#pragma omp parallel for default(none) shared(p, render, y, out, asx, asy, sc, map, final_xshift, final_yshift, progress) collapse (2)
+#pragma omp parallel for default(none) shared(p, render, y, out, asx, asy, sc, map, grid, final_xshift, final_yshift, progress) collapse (2)
 	    for (int row = 0; row < out.get_n_rows (); row++)
 	      for (int x = 0; x < p.width; x++)
 		{
@@ -268,7 +391,7 @@ produce_file (render_to_file_params &p, scr_to_img_parameters &param, image_data
 			for (int ax = 0 ; ax < p.antialias; ax++)
 			  {
 			    scr = p.common_map->final_to_scr ({finalp.x + (ax + 0.5) * asx, finalp.y + (ay + 0.5) * asy}) - p.pos;
-			    d += sample_data_scr (render, map, scr.x, scr.y);
+			    d += sample_data_scr (render, map, grid, scr.x, scr.y);
 			  }
 		      d.red *= sc;
 		      d.green *= sc;
@@ -288,7 +411,7 @@ produce_file (render_to_file_params &p, scr_to_img_parameters &param, image_data
 		    progress->inc_progress ();
 		}
 	  else if (p.geometry == render_to_file_params::screen_geometry)
-#pragma omp parallel for default(none) shared(p, render, y, out, asx, asy, sc, map, final_xshift, final_yshift, progress) collapse (2)
+#pragma omp parallel for default(none) shared(p, render, y, out, asx, asy, sc, map, grid, final_xshift, final_yshift, progress) collapse (2)
 	    for (int row = 0; row < out.get_n_rows (); row++)
 	      for (int x = 0; x < p.width; x++)
 		{
@@ -297,7 +420,7 @@ produce_file (render_to_file_params &p, scr_to_img_parameters &param, image_data
 		  coord_t yy = (y + row) * p.ystep + p.start.y;
 		  for (int ay = 0 ; ay < p.antialias; ay++)
 		    for (int ax = 0 ; ax < p.antialias; ax++)
-		      d += sample_data_final (render, map, xx + (ax + 0.5) * asx, yy + (ay + 0.5) * asy, final_xshift, final_yshift);
+		      d += sample_data_final (render, map, grid, xx + (ax + 0.5) * asx, yy + (ay + 0.5) * asy, final_xshift, final_yshift);
 		  d.red *= sc;
 		  d.green *= sc;
 		  d.blue *= sc;
@@ -358,7 +481,7 @@ produce_file (render_to_file_params &p, scr_to_img_parameters &param, image_data
     T - rendering engine type.
     SAMPLE_DATA_FINAL, SAMPLE_DATA_SCR - sampling policy functions.
     P - implementation-specific parameters for T.  */
-template<typename T, rgbdata (sample_data_final)(T &render, scr_to_img &map, coord_t x, coord_t y, int, int), rgbdata (sample_data_scr)(T &render, scr_to_img &map, coord_t x, coord_t y), typename P>
+template<typename T, rgbdata (sample_data_final)(T &render, scr_to_img &map, const coordinate_grid &grid, coord_t x, coord_t y, int, int), rgbdata (sample_data_scr)(T &render, scr_to_img &map, const coordinate_grid &grid, coord_t x, coord_t y), typename P>
 const char *
 produce_file (render_to_file_params &rfparams,
 	      render_type_parameters &rtparam, scr_to_img_parameters sparam, P &param, render_parameters &rparam, image_data &img, int black, progress_info *progress)
@@ -375,7 +498,7 @@ produce_file (render_to_file_params &rfparams,
   }
 
   // TODO: For HDR output we want to linearize the ICC profile.
-  return produce_file<T, sample_data_final, sample_data_scr> (rfparams, sparam, img, render, black, progress);
+  return produce_file<T, sample_data_final, sample_data_scr> (rfparams, sparam, img, render, black, progress, rtparam.coordinate_error);
 }
 }
 }
@@ -18,6 +18,7 @@ class screen;
 class screen_table;
 class saturation_loss_table;
 struct render_to_file_params;
+struct tile_renderer_state;
 
 
 /* Table of screens for adaptive sharpening/blurring.  */
@@ -226,13 +227,18 @@ public:
 
   /* Render TILE of image IMG for PARAM, RPARAM and RTPARAM.
      Update PROGRESS.  XOFFSET, YOFFSET, STEP and ROWSTRIDE, PIXELBYTES, WIDTH, HEIGHT
-     specify tile geometry.  */
+     specify tile geometry.  If COMPLETED_ROWS is non-NULL, set its HEIGHT
+     entries to 1 for rows finished before cancellation and to 0 for
+     others.  If STATE is non-NULL, reuse renderers it keeps from previous
+     tiles.  */
   static bool render_tile (render_type_parameters rtparam,
                            scr_to_img_parameters &param, image_data &img,
                            render_parameters &rparam, unsigned char *pixels,
                            int rowstride, int pixelbytes, int width,
                            int height, double xoffset, double yoffset,
-                           double step, progress_info *progress = NULL);
+                           double step, progress_info *progress = NULL,
+                           uint8_t *completed_rows = NULL,
+                           tile_renderer_state *state = NULL);
 
   /* Render image IMG to file RFPARAMS for RTPARAM, PARAM, RPARAM and BLACK point.
      Update PROGRESS.  */
@@ -255,7 +261,9 @@ public:
      if ANTICIPATE_SHARPENING is true.  RED_STRIP_WIDTH and
      DUFAY_GREEN_STRIP_HEIGHT specify strip widths.  Update PROGRESS, return
      the screen identifier in ID, and return the required finite-image
-     sampling operation in SAMPLING when those pointers are non-null.  */
+     sampling operation in SAMPLING when those pointers are non-null.
+     Richardson-Lucy sharpening stops once its relative update drops below
+     RICHARDSON_LUCY_TOLERANCE.  */
   static std::shared_ptr<screen> get_screen (enum scr_type t, bool preview,
 			     bool anticipate_sharpening,
     			     const sharpen_parameters &sharpen,
@@ -264,7 +272,8 @@ public:
                              progress_info *progress = NULL,
                              uint64_t *id = NULL,
                              screen_sampling *sampling = NULL,
-                             bool *cache_hit = NULL);
+                             bool *cache_hit = NULL,
+                             luminosity_t richardson_lucy_tolerance = 0);
 
   /* Release screen S.  */
   static void release_screen (screen *s);
@@ -343,11 +352,19 @@ public:
   /* Precompute all data needed for rendering.  Update PROGRESS.  */
   nodiscard_attr bool
   precompute_all (progress_info *progress = NULL)
+  {
+    return precompute_img_range ({ 0, 0, m_img.width, m_img.height },
+                                 progress);
+  }
+
+  /* Precompute all data needed for rendering in AREA.  Update PROGRESS.  */
+  nodiscard_attr bool
+  precompute_img_range (int_image_area area, progress_info *progress = NULL)
   {
     int flags = m_color ? PRECOMPUTE_RGB_IMAGE : PRECOMPUTE_IMAGE_LAYER;
     if (m_profiled)
       flags |= NORMALIZED_PATCHES;
-    if (!render_to_scr::precompute_all (flags, progress))
+    if (!render_to_scr::precompute_img_range (flags, area, progress))
       return false;
     /* When doing profiled matrix, we need to pre-scale the profile so
        black point corretion goes right. Without doing so, for exmaple
@@ -359,14 +376,6 @@ public:
     return true;
   }
 
-  /* Precompute all data needed for rendering in AREA.  Update PROGRESS.  */
-  nodiscard_attr bool
-  precompute_img_range (int_image_area area, progress_info *progress = NULL)
-  {
-    (void)area;
-    return precompute_all (progress);
-  }
-
   /* Sample pixel at position P in image coordinates.  */
   pure_attr inline rgbdata
   sample_pixel_img (point_t p) const
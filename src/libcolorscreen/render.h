@@ -86,6 +86,50 @@ do_account (T *data, T val, luminosity_t scale)
     account_pixel<UseAtomic> (data, val, scale);
 }
 
+/* Return 4 luminosities stored at P.  */
+pure_attr inline vec_luminosity_t always_inline_attr
+load_vec_luminosity (const float *p) noexcept
+{
+  return (vec_luminosity_t){ p[0], p[1], p[2], p[3] };
+}
+
+/* Return 4 half float luminosities stored at P.  */
+pure_attr inline vec_luminosity_t always_inline_attr
+load_vec_luminosity (const half_luminosity_t *p) noexcept
+{
+#ifdef __F16C__
+  __m128 f = _mm_cvtph_ps (_mm_loadl_epi64 ((const __m128i *)p));
+  return (vec_luminosity_t){ f[0], f[1], f[2], f[3] };
+#else
+  return (vec_luminosity_t){ (luminosity_t)p[0], (luminosity_t)p[1],
+                             (luminosity_t)p[2], (luminosity_t)p[3] };
+#endif
+}
+
+/* Interpolate bicubically the 4x4 block of DATA with top left corner at
+   index I.  WIDTH is the row stride of DATA and OFF is the position within
+   the central cell.  Templated by the storage type S so the storage is
+   dispatched once per sample rather than for every value read.  */
+template <typename S>
+pure_attr inline luminosity_t always_inline_attr
+bicubic_interpolate_block (const S *data, size_t i, int width,
+                           point_t off) noexcept
+{
+  return do_bicubic_interpolate (
+      load_vec_luminosity (data + i),
+      load_vec_luminosity (data + i + width),
+      load_vec_luminosity (data + i + 2 * (size_t)width),
+      load_vec_luminosity (data + i + 3 * (size_t)width), off);
+}
+
+#ifdef COLORSCREEN_RUNTIME_F16C
+/* Same as bicubic_interpolate_block for half floats.  Kept out of line so
+   the float storage path in render::interpolate_block contains no call.  */
+pure_attr luminosity_t
+bicubic_interpolate_half_block (const half_luminosity_t *data, size_t i,
+                                int width, point_t off) noexcept;
+#endif
+
 /* Base class for rendering routines.  */
 class render
 {
@@ -165,6 +209,14 @@ public:
                                                  rgbdata patch_proportions,
                                                  progress_info *progress);
 
+  /* Same as precompute_all but the image layer and RGB image are guaranteed
+     to be valid only for pixels in AREA.  Data of huge scans are computed
+     lazily in tiles, so small areas are precomputed quickly.  */
+  nodiscard_attr DLL_PUBLIC bool precompute_img_range (int flags,
+                                                       rgbdata patch_proportions,
+                                                       int_image_area area,
+                                                       progress_info *progress);
+
   /* Get linearized RGB pixel value at index X, Y.  If a sharpened RGB image
      was precomputed, return its independently processed scanner channels.
      The three M_RGB_IMAGE planes are always present or absent together.  */
@@ -250,8 +302,8 @@ public:
     return 128 * 1024;
   }
 
-  /* Fetch histogram for the current scan area.  Report progress to PROGRESS.
-   */
+  /* Fetch histogram for the current scan area.  The image layer must be
+     precomputed for the whole scan area.  Report progress to PROGRESS.  */
   std::shared_ptr<histogram> get_image_layer_histogram (progress_info *progress
                                                         = nullptr);
 
@@ -311,7 +363,7 @@ protected:
   uint64_t m_image_layer_id = m_img.id;
 
   /* Precomputed scalar image layer used by grayscale/screen rendering.  */
-  mem_luminosity_t *m_image_layer = nullptr;
+  mem_luminosity_ptr m_image_layer;
 
   /* Wrapping class to cause proper destruction.  */
   std::shared_ptr<class sharpened_data> m_image_layer_holder = nullptr;
@@ -319,9 +371,24 @@ protected:
   /* Independently scanner-sharpened native RGB channels.  Values are
      linearized and backlight-corrected, but global dark point and exposure are
      still applied by the higher-level RGB accessors.  */
-  mem_luminosity_t *m_rgb_image[3] = { nullptr, nullptr, nullptr };
+  mem_luminosity_ptr m_rgb_image[3];
   std::shared_ptr<class sharpened_data> m_rgb_image_holder[3];
 
+  /* Interpolate bicubically the 4x4 block of DATA with top left corner at
+     index I and position OFF within the central cell.  */
+  pure_attr inline luminosity_t always_inline_attr
+  interpolate_block (mem_luminosity_ptr data, size_t i,
+                     point_t off) const noexcept
+  {
+    if (!data.h)
+      return bicubic_interpolate_block (data.f, i, m_img.width, off);
+#ifdef COLORSCREEN_RUNTIME_F16C
+    return bicubic_interpolate_half_block (data.h, i, m_img.width, off);
+#else
+    return bicubic_interpolate_block (data.h, i, m_img.width, off);
+#endif
+  }
+
   /* Maximal value in M_IMG.  */
   int m_maxval = m_img.has_grayscale_or_ir () ? m_img.maxval : 65535;
 
@@ -461,25 +528,9 @@ render::get_unadjusted_img_pixel (point_t p) const noexcept
   coord_t ry = my_modf (p.y, &sy);
 
   if (sx >= 1 && sx < m_img.width - 2 && sy >= 1 && sy < m_img.height - 2)
-    {
-      vec_luminosity_t v1 = { get_unadjusted_data ({ sx - 1, sy - 1 }),
-                              get_unadjusted_data ({ sx, sy - 1 }),
-                              get_unadjusted_data ({ sx + 1, sy - 1 }),
-                              get_unadjusted_data ({ sx + 2, sy - 1 }) };
-      vec_luminosity_t v2 = { get_unadjusted_data ({ sx - 1, sy - 0 }),
-                              get_unadjusted_data ({ sx, sy - 0 }),
-                              get_unadjusted_data ({ sx + 1, sy - 0 }),
-                              get_unadjusted_data ({ sx + 2, sy - 0 }) };
-      vec_luminosity_t v3 = { get_unadjusted_data ({ sx - 1, sy + 1 }),
-                              get_unadjusted_data ({ sx, sy + 1 }),
-                              get_unadjusted_data ({ sx + 1, sy + 1 }),
-                              get_unadjusted_data ({ sx + 2, sy + 1 }) };
-      vec_luminosity_t v4 = { get_unadjusted_data ({ sx - 1, sy + 2 }),
-                              get_unadjusted_data ({ sx, sy + 2 }),
-                              get_unadjusted_data ({ sx + 1, sy + 2 }),
-                              get_unadjusted_data ({ sx + 2, sy + 2 }) };
-      return do_bicubic_interpolate (v1, v2, v3, v4, { rx, ry });
-    }
+    return interpolate_block (m_image_layer,
+                              (sy - 1) * (size_t)m_img.width + sx - 1,
+                              { rx, ry });
   return 0;
 }
 
@@ -503,6 +554,14 @@ render::get_unadjusted_img_rgb_pixel (point_t p) const noexcept
   coord_t rx = my_modf (p.x, &sx);
   coord_t ry = my_modf (p.y, &sy);
 
+  if (sx >= 1 && sx < m_img.width - 2 && sy >= 1 && sy < m_img.height - 2
+      && m_rgb_image[0])
+    {
+      size_t i = (sy - 1) * (size_t)m_img.width + sx - 1;
+      return { interpolate_block (m_rgb_image[0], i, { rx, ry }),
+               interpolate_block (m_rgb_image[1], i, { rx, ry }),
+               interpolate_block (m_rgb_image[2], i, { rx, ry }) };
+    }
   if (sx >= 1 && sx < m_img.width - 2 && sy >= 1 && sy < m_img.height - 2)
     {
       rgbdata ret;
@@ -559,7 +618,7 @@ render::get_unadjusted_img_rgb_pixel (point_t p) const noexcept
                               get_linearized_data_blue ({ sx + 1, sy + 2 }),
                               get_linearized_data_blue ({ sx + 2, sy + 2 }) };
       ret.blue = do_bicubic_interpolate (b1, b2, b3, b4, { rx, ry });
-      if (m_backlight_correction && !m_rgb_image[0])
+      if (m_backlight_correction)
         {
           ret.red = m_backlight_correction->apply (
               ret.red, p.x, p.y, backlight_correction_parameters::red, true);
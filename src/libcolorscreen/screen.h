@@ -45,6 +45,9 @@ public:
   static const int size=128;
   /* blur radius is in screen coordiates. 0.25 makes almost invisible.  */
   constexpr static const coord_t max_blur_radius = 0.25;
+  /* Relative update at which Richardson-Lucy sharpening of screens for
+     interactive previews stops iterating.  */
+  constexpr static const luminosity_t preview_richardson_lucy_tolerance = 1e-4;
   /* Multiplicative transmission and additive preview contribution.  */
   luminosity_t mult[size][size][3];
   luminosity_t add[size][size][3];
@@ -112,8 +115,11 @@ public:
   /* Initialize THIS from SCR after applying the capture transfer described by
      SHARPEN.  ANTICIPATE_SHARPENING additionally applies the selected digital
      inverse filter; when false, only the forward capture blur is applied.
-     PARALLEL permits OpenMP in expensive PSF construction.  ADD is copied
-     unchanged from SCR.  Return false if transfer/PSF construction fails.
+     PARALLEL permits OpenMP in expensive PSF construction and Richardson-Lucy
+     deconvolution of independent channels.  Richardson-Lucy stops once the
+     relative update of the estimate drops below RICHARDSON_LUCY_TOLERANCE;
+     0 runs all iterations.  ADD is copied unchanged from SCR.  Return false
+     if transfer/PSF construction fails.
      On failure THIS may be only partly initialized; the caller must discard or
      otherwise ignore it rather than attempting to preserve the old contents.  */
   nodiscard_attr DLL_PUBLIC bool
@@ -121,7 +127,9 @@ public:
                                       sharpen_parameters *sharpen[3],
                                       bool anticipate_sharpening,
                                       bool parallel = true,
-                                      screen_filter_profile *profile = nullptr);
+                                      screen_filter_profile *profile = nullptr,
+                                      luminosity_t richardson_lucy_tolerance
+                                      = 0);
   /* Prepare the source-side Fourier state of THIS for repeated periodic
      capture filtering.  The resulting SOURCE is immutable and may be shared
      by multiple threads.  PROFILE, when nonnull, records the three forward
@@ -141,6 +149,16 @@ public:
       const screen_filter_source &source,
       sharpen_parameters *sharpen[3], bool anticipate_sharpening,
       bool parallel = true, screen_filter_profile *profile = nullptr);
+  /* Initialize THIS by Gaussian blur of a source previously prepared by
+     PREPARE_FILTER_SOURCE with per-channel BLUR_RADIUS.  The separable
+     transfer of the FIR kernel used by the 1D FFT blur is applied to the
+     source spectra, so the result matches INITIALIZE_WITH_BLUR with BLUR_FFT
+     up to roundoff while omitting the source forward FFTs.  Return false if
+     SOURCE is not prepared.  */
+  nodiscard_attr bool
+  initialize_with_blur (const screen_filter_source &source,
+                        rgbdata blur_radius,
+                        screen_filter_profile *profile = nullptr);
   /* Initialize screen to the dufaycolor screen plate.  */
   void dufay (coord_t red_strip_width, coord_t green_strip_width);
   void strip (coord_t first_strip_width, coord_t second_strip_width, int color1, int color2, int color3);
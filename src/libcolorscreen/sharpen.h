@@ -50,7 +50,7 @@ do_unsharp_mask(mem_O *out, T data, P param, int width, int height, int clen, lu
     luminosity_t *rotated_cmatrix = (luminosity_t *)malloc (clen * sizeof (luminosity_t));
 #ifdef _OPENMP
     int tn = !parallel ? 0 : omp_get_thread_num ();
-    int threads = !parallel ? 1 : omp_get_max_threads ();
+    int threads = !parallel ? 1 : omp_get_num_threads ();
 #else
     int tn = 0;
     int threads = 1;
@@ -59,11 +59,15 @@ do_unsharp_mask(mem_O *out, T data, P param, int width, int height, int clen, lu
     int yend = (tn + 1) * height / threads - 1;
     O *line = (O *)malloc (width * sizeof (O));
 
-    for (int d = -clen/2; d < clen/2 - 1; d++)
+    /* The window of row Y reads the ring slot of row Y - clen/2 - 1 in place
+       of row Y + clen/2 (which is filled only when row Y + 1 is produced).
+       Fill it also at the start of a thread chunk, so the result does not
+       depend on the number of threads.  */
+    for (int d = -clen/2 - 1; d < clen/2 - 1; d++)
       {
 	int yp = ystart + d;
 	int tp = (yp + clen) % clen;
-	if (yp < 0 || yp > height)
+	if (yp < 0 || yp >= height)
 	  memset ((void *)(hblur + tp * width), 0, sizeof (O) * width);
 	else
 	{
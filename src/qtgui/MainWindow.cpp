@@ -1747,6 +1747,24 @@ void MainWindow::createMenus() {
   redoAction->setShortcut(QKeySequence::Redo);
   editMenu->addAction(redoAction);
 
+  editMenu->addSeparator();
+  // Process-wide storage precision of large intermediate buffers; persisted
+  // in QSettings and applied to data computed after the change.
+  QAction *halfFloatAction = editMenu->addAction(tr("Reduce &Memory Use"));
+  halfFloatAction->setCheckable(true);
+  halfFloatAction->setChecked(
+      QSettings()
+          .value("halfFloatStorage", colorscreen::half_float_storage_p())
+          .toBool());
+  colorscreen::set_half_float_storage(halfFloatAction->isChecked());
+  halfFloatAction->setToolTip(
+      "Store linearized and sharpened scan data as 16bit floats.  This "
+      "halves memory use for a small loss of precision.");
+  connect(halfFloatAction, &QAction::toggled, this, [](bool checked) {
+    colorscreen::set_half_float_storage(checked);
+    QSettings().setValue("halfFloatStorage", checked);
+  });
+
   // View Menu
   m_viewMenu = menuBar()->addMenu("&View");
 
@@ -2029,7 +2047,7 @@ bool MainWindow::saveParametersToFile(const QString &fileName) {
   const bool hasRgb = m_scan && m_scan->has_rgb();
   bool saved = colorscreen::save_csp(
       f, &m_scrToImgParams, hasRgb ? &m_detectParams : nullptr, &m_rparams,
-      &m_solverParams);
+      &m_solverParams, absoluteFileName.toUtf8().constData());
   if (fclose(f) != 0)
     saved = false;
 
@@ -2705,7 +2723,8 @@ void MainWindow::loadFile(const QString &fileName, bool suppressParamPrompt) {
           colorscreen::solver_parameters emptySolver;
           m_solverParams = emptySolver;
           if (!colorscreen::load_csp(f, &m_scrToImgParams, &m_detectParams,
-                                     &m_rparams, &m_solverParams, &error)) {
+                                     &m_rparams, &m_solverParams, &error,
+                                     parFile.toUtf8().constData())) {
             QMessageBox::warning(this, "Error Loading Parameters",
                                  error ? QString::fromUtf8(error)
                                        : "Unknown error loading parameters.");
@@ -3594,12 +3613,15 @@ void MainWindow::saveRecoveryState() {
     const bool hasRgb = m_scan->has_rgb();
     paramsSaved = colorscreen::save_csp(
         f, &m_scrToImgParams, hasRgb ? &m_detectParams : nullptr, &m_rparams,
-        &m_solverParams);
+        &m_solverParams, paramsPath.toUtf8().constData());
     if (fclose(f) != 0)
       paramsSaved = false;
   }
-  if (!paramsSaved)
+  if (!paramsSaved) {
     QFile::remove(paramsPath);
+    // save_csp may have written the binary sidecar before failing.
+    QFile::remove(paramsPath + QStringLiteral(".cspdata"));
+  }
 
   QFile metaFile(
       directory.filePath(QStringLiteral("recovery_params_meta.txt")));
@@ -3640,7 +3662,7 @@ bool MainWindow::restoreRecoveryState() {
       const char *error = nullptr;
       const bool loaded = colorscreen::load_csp(
           f, &m_scrToImgParams, &m_detectParams, &m_rparams, &m_solverParams,
-          &error);
+          &error, paramsPath.toUtf8().constData());
       fclose(f);
       if (!loaded || error) {
         QMessageBox::warning(
@@ -4150,7 +4172,8 @@ bool MainWindow::loadParameterFile(const QString &fileName) {
   m_solverParams = colorscreen::solver_parameters();
 
   if (!colorscreen::load_csp(f, &m_scrToImgParams, &m_detectParams, &m_rparams,
-                             &m_solverParams, &error)) {
+                             &m_solverParams, &error,
+                             fileName.toUtf8().constData())) {
     fclose(f);
     QString errStr =
         error ? QString::fromUtf8(error) : "Unknown error loading parameters.";